@@ -22,19 +22,25 @@
 
 void SlotsGrid::paint(Graphics& g) {
   if (m_numOfSlotsPerSide != 0) {
-    auto bounds = getLocalBounds();
     m_slotSize = jmin(getWidth() / m_numOfSlotsPerSide, getHeight() / m_numOfSlotsPerSide);
+    if (m_slotSize <= 0)
+      return;
 
-    int slotIndex = 0;
-    for (int i = 0; i < m_numOfSlotsPerSide; ++i) {
-      auto rowBounds = bounds.removeFromTop(m_slotSize);
-      for (int j = 0; j < m_numOfSlotsPerSide; ++j) {
-        const auto slotRect = rowBounds.removeFromLeft(m_slotSize);
+    // Only the slots inside the clip region are painted, so repainting a few slots stays cheap.
+    const auto clip = g.getClipBounds();
+    const int firstRow = jlimit(0, m_numOfSlotsPerSide, clip.getY() / m_slotSize);
+    const int lastRow = jlimit(0, m_numOfSlotsPerSide, clip.getBottom() / m_slotSize + 1);
+    const int firstColumn = jlimit(0, m_numOfSlotsPerSide, clip.getX() / m_slotSize);
+    const int lastColumn = jlimit(0, m_numOfSlotsPerSide, clip.getRight() / m_slotSize + 1);
+
+    for (int i = firstRow; i < lastRow; ++i) {
+      for (int j = firstColumn; j < lastColumn; ++j) {
+        const int slotIndex = i * m_numOfSlotsPerSide + j;
+        const Rectangle<int> slotRect(j * m_slotSize, i * m_slotSize, m_slotSize, m_slotSize);
         g.setColour(getSlotColour(slotIndex, m_highlightedSlot == slotIndex));
         g.fillRect(slotRect);
         g.setColour(Colours::black);
         g.drawRect(slotRect);
-        ++slotIndex;
       }
     }
   }
@@ -81,6 +87,22 @@ int SlotsGrid::getSlotIndex(const Point<float>& pos) {
   return -1;
 }
 
+void SlotsGrid::repaintSlots(const SparseSet<int>& slots) {
+  if (m_slotSize <= 0 || m_numOfSlotsPerSide == 0) {
+    repaint();
+    return;
+  }
+
+  for (int i = 0; i < slots.getNumRanges(); ++i) {
+    const auto range = slots.getRange(i);
+    for (int slotIndex = range.getStart(); slotIndex < range.getEnd(); ++slotIndex) {
+      const int row = slotIndex / m_numOfSlotsPerSide;
+      const int column = slotIndex % m_numOfSlotsPerSide;
+      repaint(column * m_slotSize, row * m_slotSize, m_slotSize, m_slotSize);
+    }
+  }
+}
+
 void SlotsGrid::updateContent() {
   m_numOfSlotsPerSide = static_cast<int>(std::ceil(std::sqrt(getNumOfSlots())));
   resized();
@@ -31,6 +31,8 @@ class SlotsGrid : public Component,
   int getSlotIndex(const Point<float>& pos);
 
   virtual void updateContent();
+  // Repaints only the given slots, e.g. the ones that changed.
+  void repaintSlots(const SparseSet<int>& slots);
   virtual Colour getSlotColour(int slotIndex, bool isHighlighted) = 0;
   virtual int getNumOfSlots() = 0;
   virtual Component* getPopupComponent(int slotIndex) = 0;
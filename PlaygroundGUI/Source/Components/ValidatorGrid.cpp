@@ -18,6 +18,7 @@
  */
 
 #include "ValidatorGrid.h"
+#include "../Utils/Bits256.h"
 
 static Colour HSV(double h, double s, double v) {
   double hh, p, q, t, ff;
@@ -146,7 +147,7 @@ void ValidatorGrid::update() {
       slots[i].owner = model->get_slot_owner(i);
       slots[i].difficulty = diff;  // BUG(kari): It is possible the difficulty to change while fetching the owner...
       slots[i].is_mine = slots[i].owner == owner ? true : false;
-      slots[i].bits = leading_bits(slots[i].difficulty);
+      slots[i].bits = Bits256::countLeadingOnes(slots[i].difficulty);
     }
 
     if (slots[i].bits && slots[i].bits < min_leading_bits) {
@@ -170,23 +171,6 @@ void ValidatorGrid::resized() {
   component_side_size_px = slots_per_side * (slot_size + gap) + gap;
 }
 
-uint32_t ValidatorGrid::leading_bits(const std::string& s) {
-  uint32_t result = 0;
-  for (uint32_t i = 0; i < s.size(); ++i) {
-    uint8_t x = s[i];
-    if (x == 0xFF) {
-      result += 8;
-    } else {
-      while (x & 0x80) {
-        result++;
-        x <<= 1;
-      }
-      break;
-    }
-  }
-  return result;
-}
-
 void ValidatorGrid::set_owner(const std::string& new_owner) {
   owner = new_owner;
 }
@@ -63,7 +63,5 @@ class ValidatorGrid: public Component {
   uint32_t gap = 0;  // no gap if slots are too many
   bool allowed_text_over_slots = true;
 
-  uint32_t leading_bits(const std::string& s);
-
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ValidatorGrid)
 };
@@ -24,6 +24,8 @@
 #include "Utils/TasksManager.h"
 #include "Utils/Utils.h"
 #include "Data/AutomatonContractData.h"
+#include "Data/ContractCache.h"
+#include "Data/JsonRpcClient.h"
 
 #include "automaton/core/interop/ethereum/eth_contract_curl.h"
 #include "automaton/core/interop/ethereum/eth_helper_functions.h"
@@ -32,9 +34,7 @@
 
 using automaton::core::common::status;
 using automaton::core::interop::ethereum::eth_contract;
-using automaton::core::interop::ethereum::eth_getBalance;
 using automaton::core::interop::ethereum::eth_transaction;
-using automaton::core::interop::ethereum::eth_getTransactionCount;
 using automaton::core::interop::ethereum::encode;
 using automaton::core::io::bin2hex;
 
@@ -65,10 +65,9 @@ static uint64 getNumOrders(AutomatonContractData::Ptr contract, status* resStatu
 static std::string getEthBalance(AutomatonContractData::Ptr contract,
                                  const std::string& m_ethAddress,
                                  status* resStatus) {
-  *resStatus = eth_getBalance(contract->getUrl(), m_ethAddress);
-  BigInteger balance;
-  balance.parseString(resStatus->msg, 16);
-  return balance.toString(10).toStdString();
+  Uint256 balance;
+  *resStatus = contract->getRpcClient()->getBalance(m_ethAddress, &balance);
+  return balance.toDecimal();
 }
 
 static std::string fetchDexEthBalance(AutomatonContractData::Ptr contract,
@@ -93,9 +92,28 @@ static std::string getAutoBalance(AutomatonContractData::Ptr contract,
 }
 
 bool DEXManager::fetchOrders() {
+  // Orders of the last session are shown until the fetch replaces them.
+  if (m_model->size() == 0) {
+    Array<Order::Ptr> orders;
+    for (const auto& record : m_contractData->getCache()->getOrders())
+      orders.add(std::make_shared<Order>(record.id, String(record.data)));
+    m_model->addItems(orders, NotificationType::sendNotification);
+  }
+
   launchTask([&](AsyncTask* task) {
     auto& s = task->m_status;
 
+    // Balances and orders only change with new blocks.
+    uint64 blockNumber = 0;
+    s = m_contractData->getBlockNumber(&blockNumber);
+    task->logStatus(s, "eth_blockNumber");
+    if (!s.is_ok()) {
+      blockNumber = 0;
+    } else if (blockNumber == m_fetchedBlock) {
+      task->setStatusMessage("No new block since the last fetch");
+      return true;
+    }
+
     auto ethBalance = getEthBalance(m_contractData, m_accountData->getAddress(), &s);
     task->logStatus(s, "getEthBalance account:" + m_accountData->getAddress());
     if (!s.is_ok())
@@ -114,14 +132,13 @@ bool DEXManager::fetchOrders() {
     m_accountData->setBalance(ethBalance, autoBalance);
     m_accountData->setDexEthBalance(dexEthBalance);
 
-    m_model->clear(NotificationType::dontSendNotification);
-
     const auto numOfOrders = getNumOrders(m_contractData, &s);
     task->logStatus(s, "getNumOrders");
     if (!s.is_ok())
       return false;
 
     Array<Order::Ptr> orders;
+    std::vector<CachedOrder> records;
     for (size_t i = 1; i <= numOfOrders; ++i) {
       json jInput;
       jInput.push_back(i);
@@ -134,11 +151,15 @@ bool DEXManager::fetchOrders() {
 
       const auto order = std::make_shared<Order>(i, String(s.msg));
       // Don't add removed orders
-      if (order->getType() != Order::Type::None)
+      if (order->getType() != Order::Type::None) {
         orders.add(order);
+        records.push_back({i, s.msg});
+      }
     }
     m_model->clear(NotificationType::dontSendNotification);
     m_model->addItems(orders, NotificationType::sendNotificationAsync);
+    m_contractData->getCache()->storeOrders(std::move(records));
+    m_fetchedBlock = blockNumber;
 
     return true;
   }, [=](AsyncTask* task) {
@@ -195,27 +216,31 @@ bool DEXManager::createBuyOrder(const String& amountAUTOwei, const String& amoun
     std::stringstream txData;
     txData << "d96a094a" << bin2hex(encode(jSignature.dump(), jBuyOrder.dump()));
 
-    s = eth_getTransactionCount(m_contractData->getUrl(), m_accountData->getAddress());
+    uint64 transactionCount = 0;
+    s = m_contractData->getRpcClient()->getTransactionCount(m_accountData->getAddress(), &transactionCount);
     task->logStatus(s, "eth_getTransactionCount account:" + m_accountData->getAddress());
-    auto nonce = s.is_ok() ? s.msg : "0";
     if (!s.is_ok())
       return false;
 
-    if (nonce.substr(0, 2) == "0x") {
-      nonce = nonce.substr(2);
-    }
+    const auto nonce = String::toHexString(static_cast<int64>(transactionCount)).toStdString();
     task->setProgress(0.5);
 
-    BigInteger intAmountETHwei;
-    intAmountETHwei.parseString(amountETHwei, 10);
-    const String hexAmountETH = intAmountETHwei.toString(16);
+    Uint256 ethWei;
+    if (!Uint256::fromDecimal(amountETHwei.toStdString(), &ethWei)) {
+      s = status::internal("Invalid ETH amount: " + amountETHwei.toStdString());
+      task->logStatus(s, "buy ETHwei:" + amountETHwei);
+      return false;
+    }
+    // A quantity in the transaction has no leading zeros.
+    auto hexAmountETH = ethWei.toHex();
+    hexAmountETH.erase(0, jmin(hexAmountETH.find_first_not_of('0'), hexAmountETH.size() - 1));
 
     eth_transaction transaction;
     transaction.nonce = nonce;
     transaction.gas_price = "1388";  // 5 000
     transaction.gas_limit = "5B8D80";  // 6M
     transaction.to = m_contractData->getAddress().substr(2);
-    transaction.value = hexAmountETH.toStdString();
+    transaction.value = hexAmountETH;
     transaction.data = txData.str();
     transaction.chain_id = "01";
     s = m_contractData->call("buy", transaction.sign_tx(m_accountData->getPrivateKey()));
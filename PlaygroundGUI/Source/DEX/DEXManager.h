@@ -18,6 +18,8 @@
  */
 
 #pragma once
+#include <atomic>
+
 #include <JuceHeader.h>
 #include <Utils/TasksOwner.h>
 #include "Order.h"
@@ -48,6 +50,8 @@ class DEXManager : public TasksOwner {
 
   Account::Ptr m_accountData;
   std::shared_ptr<AutomatonContractData> m_contractData;
+  // Chain head of the last successful fetchOrders(), which is skipped until the head moves.
+  std::atomic<uint64> m_fetchedBlock {0};
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DEXManager)
 };
@@ -34,9 +34,14 @@ Order::Order(uint64 id, const String& jsonString)
   const auto amountAUTOstr = jsonData.at(0).get<std::string>();
   const auto amountETHstr = jsonData.at(1).get<std::string>();
 
-  m_auto = Utils::fromWei(CoinUnit::AUTO, amountAUTOstr);
-  m_eth = Utils::fromWei(CoinUnit::ether, amountETHstr);
-  m_price = Utils::divideBigInt(amountETHstr, amountAUTOstr, 10);
+  // Parsed once for the amounts and the price.
+  Uint256 amountAUTO;
+  Uint256 amountETH;
+  if (Uint256::fromDecimal(amountAUTOstr, &amountAUTO) && Uint256::fromDecimal(amountETHstr, &amountETH)) {
+    m_auto = Utils::fromWei(CoinUnit::AUTO, amountAUTO);
+    m_eth = Utils::fromWei(CoinUnit::ether, amountETH);
+    m_price = Utils::divideBigInt(amountETH, amountAUTO, 10);
+  }
 
   m_owner = jsonData.at(2).get<std::string>();
   m_type = static_cast<Order::Type>(std::stoul(jsonData.at(3).get<std::string>()));
@@ -0,0 +1,207 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <json.hpp>
+#include <map>
+
+#include "AdaptivePager.h"
+#include "RpcRecorder.h"
+#include "Config/Config.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+
+static const char* const PAGE_SIZES_FIELD = "page_sizes";
+
+// Config file access of all pagers, page_sizes is read and written as a whole.
+static CriticalSection& getConfigLock() {
+  static CriticalSection lock;
+  return lock;
+}
+
+AdaptivePager::AdaptivePager(const Options& options)
+    : m_options(options)
+    , m_pageSize(jlimit(options.minSize, options.maxSize, options.initialSize))
+    , m_ceiling(options.maxSize) {
+}
+
+AdaptivePager::~AdaptivePager() {
+}
+
+std::shared_ptr<AdaptivePager> AdaptivePager::getShared(const std::string& url,
+                                                        const std::string& kind,
+                                                        const Options& options) {
+  static CriticalSection pagersLock;
+  static std::map<std::string, std::weak_ptr<AdaptivePager>> pagers;
+
+  const ScopedLock sl(pagersLock);
+  auto& entry = pagers[url + " " + kind];
+  if (auto pager = entry.lock())
+    return pager;
+
+  auto remembered = options;
+  const bool frozen = RpcRecorder::getInstance()->isActive();
+  if (!frozen) {
+    const ScopedLock configLock(getConfigLock());
+    const auto sizes = ConfigFile::getInstance()->get_json(PAGE_SIZES_FIELD);
+    if (sizes.is_object() && sizes.count(url) && sizes[url].is_object() && sizes[url].count(kind)
+        && sizes[url][kind].is_number_unsigned())
+      remembered.initialSize = sizes[url][kind].get<uint32_t>();
+  }
+
+  auto pager = std::make_shared<AdaptivePager>(remembered);
+  pager->m_url = url;
+  pager->m_kind = kind;
+  pager->m_frozen = frozen;
+  entry = pager;
+  return pager;
+}
+
+uint32_t AdaptivePager::getPageSize() const {
+  const ScopedLock sl(m_lock);
+  return m_pageSize;
+}
+
+void AdaptivePager::recordSuccess(uint32_t entries, double milliseconds, size_t responseBytes) {
+  const ScopedLock sl(m_lock);
+  if (m_frozen)
+    return;
+
+  const bool slow = milliseconds > m_options.targetMs;
+  const bool large = responseBytes > m_options.maxResponseBytes;
+  if (slow || large) {
+    // Size at which this page would have been within both limits.
+    double scale = 1.0;
+    if (slow)
+      scale = m_options.targetMs / milliseconds;
+    if (large)
+      scale = jmin(scale, static_cast<double>(m_options.maxResponseBytes) / responseBytes);
+    setPageSize(jmin(m_pageSize, static_cast<uint32_t>(entries * scale)));
+    return;
+  }
+
+  // Only full pages tell how the current size does, the last page of a read is usually shorter.
+  if (entries >= m_pageSize && 2 * milliseconds < m_options.targetMs
+      && 2 * responseBytes < m_options.maxResponseBytes)
+    setPageSize(jmin(m_ceiling, 2 * m_pageSize));
+}
+
+bool AdaptivePager::recordFailure(uint32_t entries, const status& s) {
+  if (!isPageSizeError(s))
+    return false;
+
+  const ScopedLock sl(m_lock);
+  if (m_frozen || entries <= m_options.minSize)
+    return false;
+
+  m_ceiling = jmax(m_options.minSize, jmin(m_ceiling, entries * 3 / 4));
+  setPageSize(jmin(m_pageSize, entries / 2));
+  DBG("Page size of " << m_kind << " on " << m_url << " reduced to " << static_cast<int>(m_pageSize)
+      << " after: " << s.msg);
+  return true;
+}
+
+bool AdaptivePager::isPageSizeError(const status& s) {
+  if (s.is_ok())
+    return false;
+
+  static const char* const messages[] = {
+    "gas", "timeout", "timed out", "too large", "too big", "exceed",
+    "http error 413", "http error 502", "http error 503", "http error 504"
+  };
+  const auto message = String(s.msg).toLowerCase();
+  for (const auto text : messages) {
+    if (message.contains(text))
+      return true;
+  }
+  return false;
+}
+
+// Called with m_lock held.
+void AdaptivePager::setPageSize(uint32_t size) {
+  size = jlimit(m_options.minSize, m_options.maxSize, size);
+  if (size == m_pageSize)
+    return;
+
+  m_pageSize = size;
+  if (m_url.empty())
+    return;
+
+  const ScopedLock configLock(getConfigLock());
+  auto config = ConfigFile::getInstance();
+  auto sizes = config->get_json(PAGE_SIZES_FIELD);
+  if (!sizes.is_object())
+    sizes = json::object();
+  sizes[m_url][m_kind] = size;
+  config->set_json(PAGE_SIZES_FIELD, sizes);
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class AdaptivePagerTest : public UnitTest {
+ public:
+  AdaptivePagerTest() : UnitTest("AdaptivePager") {
+  }
+
+  void runTest() override {
+    AdaptivePager::Options options;
+    options.initialSize = 1024;
+    options.minSize = 16;
+    options.maxSize = 8192;
+    options.targetMs = 1000;
+    options.maxResponseBytes = 1024 * 1024;
+
+    beginTest("Grow");
+    AdaptivePager pager(options);
+    pager.recordSuccess(1024, 100, 1000);
+    expectEquals(static_cast<int>(pager.getPageSize()), 2048);
+    // A short last page doesn't count.
+    pager.recordSuccess(100, 10, 100);
+    expectEquals(static_cast<int>(pager.getPageSize()), 2048);
+    for (int i = 0; i < 5; ++i)
+      pager.recordSuccess(pager.getPageSize(), 100, 1000);
+    expectEquals(static_cast<int>(pager.getPageSize()), 8192);
+
+    beginTest("Shrink");
+    pager.recordSuccess(8192, 4000, 1000);
+    expectEquals(static_cast<int>(pager.getPageSize()), 2048);
+    pager.recordSuccess(2048, 100, 4 * 1024 * 1024);
+    expectEquals(static_cast<int>(pager.getPageSize()), 512);
+    // Neither fast nor slow.
+    pager.recordSuccess(512, 700, 1000);
+    expectEquals(static_cast<int>(pager.getPageSize()), 512);
+
+    beginTest("Failures");
+    expect(!pager.recordFailure(512, automaton::core::common::status::internal("execution reverted")));
+    expectEquals(static_cast<int>(pager.getPageSize()), 512);
+    expect(pager.recordFailure(512, automaton::core::common::status::unavailable("Timeout was reached")));
+    expectEquals(static_cast<int>(pager.getPageSize()), 256);
+    // Never grows back to the size that failed.
+    for (int i = 0; i < 5; ++i)
+      pager.recordSuccess(pager.getPageSize(), 100, 1000);
+    expectEquals(static_cast<int>(pager.getPageSize()), 384);
+
+    while (pager.recordFailure(pager.getPageSize(), automaton::core::common::status::internal("out of gas"))) {
+    }
+    expectEquals(static_cast<int>(pager.getPageSize()), 16);
+  }
+};
+
+static AdaptivePagerTest test;
+#endif
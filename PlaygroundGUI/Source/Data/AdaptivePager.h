@@ -0,0 +1,79 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "JuceHeader.h"
+#include "automaton/core/common/status.h"
+
+// Number of entries per request of a bulk read (slot pages, claim times, eth_call batches), adapted to the node.
+//
+// Pages double while they come back well within the target time and response size, and shrink in proportion when
+// they take longer or get bigger. A page that the node fails with a gas, timeout or size error is halved and should
+// be read again at the new size, and the size then stays below the one that failed. Slow nodes settle on small pages,
+// fast local ones on large pages. Thread safe, pages in flight at the same time can all report.
+class AdaptivePager {
+ public:
+  struct Options {
+    uint32_t initialSize = 1024;
+    uint32_t minSize = 16;
+    uint32_t maxSize = 16384;
+    double targetMs = 1000;
+    size_t maxResponseBytes = 8 * 1024 * 1024;
+  };
+
+  explicit AdaptivePager(const Options& options);
+  ~AdaptivePager();
+
+  // The pager of a kind of read on a node, shared by everything reading it at the same time. Starts with the size
+  // remembered in the page_sizes field of the config file, where its size is kept for the next session.
+  //
+  // While RPC traffic is recorded or replayed the pager stays at the initial size of the options and remembers
+  // nothing, so both sessions send the same pages and a replay finds them in the recording.
+  static std::shared_ptr<AdaptivePager> getShared(const std::string& url,
+                                                  const std::string& kind,
+                                                  const Options& options);
+
+  uint32_t getPageSize() const;
+
+  void recordSuccess(uint32_t entries, double milliseconds, size_t responseBytes);
+  // True when a smaller page may succeed. The page size was reduced then and the entries should be read again.
+  bool recordFailure(uint32_t entries, const automaton::core::common::status& s);
+
+  // Whether a failure looks like the node refusing a request that is too large: out of gas, timeouts, size limits.
+  static bool isPageSizeError(const automaton::core::common::status& s);
+
+ private:
+  Options m_options;
+  mutable CriticalSection m_lock;
+  uint32_t m_pageSize;
+  // Below the smallest size that failed.
+  uint32_t m_ceiling;
+  bool m_frozen = false;
+
+  std::string m_url;
+  std::string m_kind;
+
+  void setPageSize(uint32_t size);
+
+  JUCE_DECLARE_NON_COPYABLE(AdaptivePager)
+};
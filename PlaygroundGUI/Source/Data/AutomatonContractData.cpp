@@ -18,11 +18,20 @@
  */
 
 #include  "AutomatonContractData.h"
+#include "AdaptivePager.h"
+#include "ContractCache.h"
+#include "ContractCallCache.h"
+#include "JsonRpcClient.h"
+#include "RpcRecorder.h"
+#include "RpcStats.h"
+#include "SlotPagesFetcher.h"
 #include "../Utils/TasksManager.h"
+#include "../Utils/Uint256.h"
 
 #include <secp256k1_recovery.h>
 #include <secp256k1.h>
 #include <json.hpp>
+#include <map>
 
 #include "automaton/core/io/io.h"
 #include "automaton/core/interop/ethereum/eth_contract_curl.h"
@@ -33,7 +42,6 @@
 using json = nlohmann::json;
 
 using automaton::core::common::status;
-using automaton::core::interop::ethereum::dec_to_i256;
 using automaton::core::interop::ethereum::eth_contract;
 using automaton::core::io::bin2hex;
 using automaton::core::io::dec2hex;
@@ -41,21 +49,112 @@ using automaton::core::io::hex2bin;
 using automaton::core::io::hex2dec;
 using automaton::core::crypto::cryptopp::Keccak_256_cryptopp;
 
+static const char* const PAGES_IN_FLIGHT_FIELD = "pages_in_flight";
+static const char* const MIN_REFRESH_INTERVAL_FIELD = "min_refresh_interval_ms";
+static const char* const CALL_CACHE_TTL_FIELD = "call_cache_ttl_ms";
+static const char* const CALL_CACHE_MAX_ENTRIES_FIELD = "call_cache_max_entries";
+static const char* const CALL_CACHE_MAX_BYTES_FIELD = "call_cache_max_bytes";
+
+// Bulk reads whose page size adapts to the node, slot pages and claim times count slots, call batches count calls.
+static const char* const SLOT_PAGES_PAGER = "slot_pages";
+static const char* const CLAIM_TIMES_PAGER = "claim_times";
+static const char* const CALL_BATCHES_PAGER = "call_batches";
+
+static std::shared_ptr<AdaptivePager> getSlotsPager(const std::string& url, const char* kind) {
+  AdaptivePager::Options options;
+  options.initialSize = AutomatonContractData::SLOTS_PAGE_SIZE;
+  return AdaptivePager::getShared(url, kind, options);
+}
+
+// The contract returns uint256 values as decimal strings. Anything that doesn't parse reads as zero.
+static Uint256 parseContractUint(const std::string& decimal) {
+  Uint256 value;
+  Uint256::fromDecimal(decimal, &value);
+  return value;
+}
+
 AutomatonContractData::AutomatonContractData(const Config& config) {
   loadAbi();
   m_config  = config;
   m_ethUrl = String(m_config.get_string("eth_url")).trim().toStdString();
   m_contractAddress = String(m_config.get_string("contract_address")).trim().toStdString();
-  m_mask = String(m_config.get_string("mask")).trim().toStdString();
-  m_minDifficulty = m_config.get_string("min_difficulty");
-  m_slotsNumber = static_cast<uint32_t>(m_config.get_number("slots_number"));
-  m_slotsClaimed = static_cast<uint32_t>(m_config.get_number("slots_claimed"));
+
+  auto snapshot = std::make_shared<ContractSnapshot>();
+  snapshot->mask = String(m_config.get_string("mask")).trim().toStdString();
+  snapshot->minDifficulty = m_config.get_string("min_difficulty");
+  snapshot->slotsNumber = static_cast<uint32_t>(m_config.get_number("slots_number"));
+  snapshot->slotsClaimed = static_cast<uint32_t>(m_config.get_number("slots_claimed"));
+  m_snapshot = snapshot;
+  m_cache = std::make_unique<ContractCache>(ContractCache::getDefaultFile(m_ethUrl, m_contractAddress),
+                                            m_ethUrl, m_contractAddress);
+  m_callCache = std::make_unique<ContractCallCache>(
+      static_cast<size_t>(m_config.get_number(CALL_CACHE_MAX_ENTRIES_FIELD, 1024)),
+      static_cast<size_t>(m_config.get_number(CALL_CACHE_MAX_BYTES_FIELD, 4 * 1024 * 1024)),
+      m_config.get_number(CALL_CACHE_TTL_FIELD, 15 * 1000));
 }
 
 AutomatonContractData::~AutomatonContractData() {
   stopOwnedTasks();
 }
 
+// More changed ranges than this are reported as all slots changed, listeners would redraw everything anyway.
+static const int MAX_CHANGED_RANGES = 1024;
+
+// Compares the candidate slots, or all slots if there are none, and the fields of two consecutive snapshots.
+static ContractChanges getChanges(const ContractSnapshot& previous,
+                                  const ContractSnapshot& next,
+                                  const std::vector<uint32_t>* candidates) {
+  ContractChanges changes;
+  changes.fields = 0;
+  if (previous.mask != next.mask)
+    changes.fields |= ContractChanges::MASK;
+  if (previous.minDifficulty != next.minDifficulty)
+    changes.fields |= ContractChanges::MIN_DIFFICULTY;
+  if (previous.slotsNumber != next.slotsNumber)
+    changes.fields |= ContractChanges::SLOTS_NUMBER;
+  if (previous.slotsClaimed != next.slotsClaimed)
+    changes.fields |= ContractChanges::SLOTS_CLAIMED;
+  if (previous.thresholdData.approvalPercentage != next.thresholdData.approvalPercentage
+      || previous.thresholdData.contestPercentage != next.thresholdData.contestPercentage)
+    changes.fields |= ContractChanges::THRESHOLDS;
+
+  if (previous.slots.size() != next.slots.size())
+    return changes;
+
+  // Ranges are built here, adding single slots to the SparseSet is quadratic.
+  int numRanges = 0;
+  int rangeStart = -1;
+  int rangeEnd = -1;
+  auto addSlot = [&](int slot) {
+    if (slot == rangeEnd) {
+      ++rangeEnd;
+      return;
+    }
+    if (rangeStart >= 0) {
+      changes.slots.addRange({rangeStart, rangeEnd});
+      ++numRanges;
+    }
+    rangeStart = slot;
+    rangeEnd = slot + 1;
+  };
+
+  const size_t numCandidates = candidates != nullptr ? candidates->size() : next.slots.size();
+  for (size_t i = 0; i < numCandidates && numRanges <= MAX_CHANGED_RANGES; ++i) {
+    const size_t slot = candidates != nullptr ? (*candidates)[i] : i;
+    if (slot < next.slots.size() && !next.slots.isSameSlot(slot, previous.slots))
+      addSlot(static_cast<int>(slot));
+  }
+  if (numRanges > MAX_CHANGED_RANGES) {
+    changes.slots.clear();
+    return changes;
+  }
+
+  if (rangeStart >= 0)
+    changes.slots.addRange({rangeStart, rangeEnd});
+  changes.allSlots = false;
+  return changes;
+}
+
 void AutomatonContractData::setData(const std::string& _eth_url,
                                     const std::string& _contractAddress,
                                     const std::string& _mask,
@@ -63,32 +162,226 @@ void AutomatonContractData::setData(const std::string& _eth_url,
                                     uint32_t _slots_number,
                                     uint32_t _slots_claimed,
                                     const ProposalThresholdData& proposalThresholdData,
-                                    const std::vector<ValidatorSlot>& _slots) {
+                                    ValidatorSlots _slots,
+                                    uint64 blockNumber) {
+  auto snapshot = std::make_shared<ContractSnapshot>();
+  snapshot->mask = _mask;
+  snapshot->minDifficulty = _min_difficulty;
+  snapshot->slotsNumber = _slots_number;
+  snapshot->slotsClaimed = _slots_claimed;
+  snapshot->thresholdData = proposalThresholdData;
+  snapshot->slots = std::move(_slots);
+  snapshot->blockNumber = blockNumber;
+
   ScopedLock sl(m_criticalSection);
   m_ethUrl = _eth_url;
   m_contractAddress = _contractAddress;
-  m_mask = _mask;
-  m_minDifficulty = _min_difficulty;
-  m_slotsNumber = _slots_number;
-  m_slotsClaimed = _slots_claimed;
-  m_proposalThresholdData = proposalThresholdData;
-  m_slots = _slots;
+  m_lastFullReadTime = Time::getCurrentTime().toMilliseconds();
 
+  snapshot->changes = getChanges(*getSnapshot(), *snapshot, nullptr);
+  publishSnapshot(snapshot);
+  m_isLoaded = true;
+  sendChangeMessage();
+}
+
+void AutomatonContractData::mergeData(const std::string& _mask,
+                                      const std::string& _min_difficulty,
+                                      uint32_t _slots_claimed,
+                                      const ProposalThresholdData& proposalThresholdData,
+                                      const std::map<uint32_t, ValidatorSlot>& changedSlots,
+                                      uint64 blockNumber) {
+  ScopedLock sl(m_criticalSection);
+  // Writers are serialized by the lock, so the current snapshot can't change while the next one is built from it.
+  const auto previous = getSnapshot();
+  auto snapshot = std::make_shared<ContractSnapshot>(*previous);
+  snapshot->mask = _mask;
+  snapshot->minDifficulty = _min_difficulty;
+  snapshot->slotsClaimed = _slots_claimed;
+  snapshot->thresholdData = proposalThresholdData;
+  snapshot->blockNumber = blockNumber;
+  std::vector<uint32_t> candidates;
+  for (const auto& changed : changedSlots) {
+    if (changed.first < snapshot->slots.size()) {
+      snapshot->slots.set(changed.first, changed.second);
+      candidates.push_back(changed.first);
+    }
+  }
+
+  snapshot->changes = getChanges(*previous, *snapshot, &candidates);
+  publishSnapshot(snapshot);
+  sendChangeMessage();
+}
+
+void AutomatonContractData::publishSnapshot(std::shared_ptr<ContractSnapshot> snapshot) {
+  snapshot->version = getSnapshot()->version + 1;
+  storeConfig(*snapshot);
+  std::atomic_store(&m_snapshot, ContractSnapshot::Ptr(snapshot));
+}
+
+ContractSnapshot::Ptr AutomatonContractData::getSnapshot() const {
+  return std::atomic_load(&m_snapshot);
+}
+
+void AutomatonContractData::storeConfig(const ContractSnapshot& snapshot) {
   m_config.set_string("eth_url", m_ethUrl);
   m_config.set_string("contract_address", m_contractAddress);
-  m_config.set_string("mask", m_mask);
-  m_config.set_string("min_difficulty", m_minDifficulty);
-  m_config.set_number("slots_number", m_slotsNumber);
-  m_config.set_number("slots_claimed", m_slotsClaimed);
+  m_config.set_string("mask", snapshot.mask);
+  m_config.set_string("min_difficulty", snapshot.minDifficulty);
+  m_config.set_number("slots_number", snapshot.slotsNumber);
+  m_config.set_number("slots_claimed", snapshot.slotsClaimed);
+}
+
+// Reads one of the slot array getters (getOwners, getDifficulties, getLastClaimTimes) for [start, start + len).
+static status readSlotsField(AutomatonContractData* contractData,
+                             const std::string& f,
+                             uint32_t start,
+                             uint32_t len,
+                             std::vector<std::string>* values) {
+  json j_input;
+  j_input.push_back(start);
+  j_input.push_back(len);
+
+  auto s = contractData->call(f, j_input.dump());
+  if (!s.is_ok()) {
+    return s;
+  }
+
+  json j_output = json::parse(s.msg);
+  *values = (*j_output.begin()).get<std::vector<std::string> >();
+  return s;
+}
+
+// Finds the slots claimed since the last read and reads them into changedSlots. Every claim updates the last claim
+// time of its slot, so only claim times are paged, and paging stops once as many changed slots as new take overs
+// were found. Owners and difficulties are then read for the changed ranges only, all in one batch.
+static status readChangedSlots(AutomatonContractData* contractData,
+                               AsyncTask* task,
+                               const std::vector<uint64>& claimTimes,
+                               uint64 newTakeOvers,
+                               std::map<uint32_t, ValidatorSlot>* changedSlots) {
+  const uint32_t slotsNumber = static_cast<uint32_t>(claimTimes.size());
+  const auto pager = getSlotsPager(contractData->getUrl(), CLAIM_TIMES_PAGER);
+  std::vector<std::string> values;
+  status s = status::ok();
+  for (uint32_t slot = 0; slot < slotsNumber && changedSlots->size() < newTakeOvers;) {
+    if (task->threadShouldExit()) {
+      return status::internal("Aborted");
+    }
+    const uint32_t step = jmin(pager->getPageSize(), slotsNumber - slot);
+    task->setProgress((1.0 * slot) / slotsNumber);
+    task->setStatusMessage("Checking claim times " + String(slot + step) + " of " + String(slotsNumber));
+
+    const double start = Time::getMillisecondCounterHiRes();
+    s = readSlotsField(contractData, "getLastClaimTimes", slot, step, &values);
+    if (!s.is_ok()) {
+      // Too large for the node, read again smaller.
+      if (pager->recordFailure(step, s))
+        continue;
+      task->logStatus(s, "getLastClaimTimes");
+      return s;
+    }
+    pager->recordSuccess(step, Time::getMillisecondCounterHiRes() - start, s.msg.size());
+
+    for (uint32_t i = 0; i < values.size() && i < step; i++) {
+      if (static_cast<uint64>(String(values[i]).getLargeIntValue()) != claimTimes[slot + i]) {
+        (*changedSlots)[slot + i].last_claim_time = values[i];
+      }
+    }
+    slot += step;
+  }
+
+  // Split the changed slots in ranges, close slots share a range.
+  static const uint32_t MAX_GAP = 32;
+  std::vector<std::pair<uint32_t, uint32_t>> ranges;
+  std::vector<ContractCall> calls;
+  for (auto it = changedSlots->begin(); it != changedSlots->end();) {
+    const uint32_t start = it->first;
+    uint32_t end = start + 1;
+    for (++it; it != changedSlots->end() && it->first - end < MAX_GAP; ++it) {
+      end = it->first + 1;
+    }
+
+    json j_input;
+    j_input.push_back(start);
+    j_input.push_back(end - start);
+    ranges.emplace_back(start, end);
+    calls.push_back({"getOwners", j_input.dump()});
+    calls.push_back({"getDifficulties", j_input.dump()});
+  }
+
+  const auto results = contractData->callBatch(calls);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    const auto& ownersResult = results[2 * i];
+    const auto& difficultiesResult = results[2 * i + 1];
+    if (!ownersResult.is_ok() || !difficultiesResult.is_ok()) {
+      s = ownersResult.is_ok() ? difficultiesResult : ownersResult;
+      task->logStatus(s, "getOwners/getDifficulties");
+      return s;
+    }
+
+    const auto owners = (*json::parse(ownersResult.msg).begin()).get<std::vector<std::string>>();
+    const auto difficulties = (*json::parse(difficultiesResult.msg).begin()).get<std::vector<std::string>>();
+    const uint32_t start = ranges[i].first;
+    for (auto it = changedSlots->lower_bound(start); it != changedSlots->end() && it->first < ranges[i].second; ++it) {
+      const size_t index = it->first - start;
+      if (index < owners.size())
+        it->second.owner = owners[index];
+      if (index < difficulties.size())
+        it->second.difficulty = parseContractUint(difficulties[index]).toBigEndian();
+    }
+  }
+
+  task->setStatusMessage(String(changedSlots->size()) + " slots changed");
+  return s;
+}
+
+bool AutomatonContractData::loadCache() {
+  int64 lastFullReadTime = 0;
+  auto snapshot = m_cache->load(&lastFullReadTime);
+  if (snapshot == nullptr)
+    return false;
+
+  ScopedLock sl(m_criticalSection);
+  // Incremental reads pick up from the cached number of take overs, unless the last full read is too old.
+  m_lastFullReadTime = lastFullReadTime;
+  publishSnapshot(snapshot);
   m_isLoaded = true;
   sendChangeMessage();
+  return true;
 }
 
-bool AutomatonContractData::readContract() {
+bool AutomatonContractData::readContract(bool fullRefresh, ReadCallback onFinished) {
+  if (!m_isLoaded)
+    loadCache();
+
+  if (m_readInFlight) {
+    if (fullRefresh && !m_readInFlightIsFull) {
+      m_fullRefreshPending = true;
+      if (onFinished != nullptr)
+        m_pendingCallbacks.push_back(onFinished);
+    } else if (onFinished != nullptr) {
+      m_readCallbacks.push_back(onFinished);
+    }
+    return true;
+  }
+
+  const auto now = Time::getCurrentTime().toMilliseconds();
+  const auto minRefreshInterval = static_cast<int64>(m_config.get_number(MIN_REFRESH_INTERVAL_FIELD, 0));
+  if (!fullRefresh && m_isLoaded && now - m_lastReadTime < minRefreshInterval) {
+    if (onFinished != nullptr)
+      onFinished(status::ok());
+    return true;
+  }
+
+  m_readInFlight = true;
+  m_readInFlightIsFull = fullRefresh;
+  if (onFinished != nullptr)
+    m_readCallbacks.push_back(onFinished);
+
   const std::string& url = m_ethUrl;
   const std::string& contractAddress = m_contractAddress;
 
-  launchTask([&](AsyncTask* task){
+  launchTask([&, fullRefresh](AsyncTask* task){
     auto& s = task->m_status;
     eth_contract::register_contract(url, contractAddress, getAbi());
     auto contract = eth_contract::get_contract(contractAddress);
@@ -98,8 +391,19 @@ bool AutomatonContractData::readContract() {
       return false;
     }
 
+    // Nothing can have changed while the chain head is still the block of the current snapshot.
+    uint64 blockNumber = 0;
+    s = getBlockNumber(&blockNumber);
+    task->logStatus(s, "eth_blockNumber");
+    if (s.is_ok() && m_isLoaded && blockNumber != 0 && blockNumber == getSnapshot()->blockNumber) {
+      task->setStatusMessage("No new block since block " + String(blockNumber));
+      return true;
+    }
+    if (!s.is_ok())
+      blockNumber = 0;
+
     task->setProgress(0.1);
-    s = contract->call("numSlots", "");
+    s = call("numSlots", "");
     task->logStatus(s, "numSlots");
     if (!s.is_ok() || task->threadShouldExit())
       return false;
@@ -111,89 +415,76 @@ bool AutomatonContractData::readContract() {
     }
     json j_output = json::parse(s.msg);
     auto slotsNumber = String(((*j_output.begin()).get<std::string>())).getIntValue();
-    std::vector<ValidatorSlot> validatorSlots;
-    validatorSlots.resize(slotsNumber);
-
-    uint32_t step = 1024;
-    for (uint32_t slot = 0; slot < slotsNumber; slot += step) {
-      if (task->threadShouldExit()) {
-        s = status::internal("Aborted");
-        std::cout << "ERROR: Aborted!" << std::endl;
-        return false;
-      }
-      if (step > slotsNumber - slot) {
-        step = slotsNumber - slot;
-      }
-      task->setProgress((1.0 * slot) / slotsNumber);
-      task->setStatusMessage(
-          "Getting slot " + String(slot + step) + " of " + String(slotsNumber));
 
-      json j_input;
-      j_input.push_back(slot);
-      j_input.push_back(step);
-      std::string params = j_input.dump();
-
-      // Fetch owners.
-      s = contract->call("getOwners", params);
-      if (!s.is_ok() || task->threadShouldExit()) {
-        std::cout << "ERROR: " << s.msg << std::endl;
-        task->logStatus(s, "getOwners");
-        return false;
-      }
-
-      // Parse owners.
-      j_output = json::parse(s.msg);
-      std::vector<std::string> owners = (*j_output.begin()).get<std::vector<std::string> >();
-      for (uint32_t i = 0; i < owners.size(); i++) {
-        validatorSlots[slot + i].owner = owners[i];
-      }
+    // The number of take overs is the change cursor of the slots.
+    s = call("numTakeOvers", "");
+    task->logStatus(s, "numTakeOvers");
+    if (!s.is_ok() || task->threadShouldExit())
+      return false;
+    j_output = json::parse(s.msg);
+    std::string slots_claimed_string = (*j_output.begin()).get<std::string>();
+    auto slotsClaimed = String(slots_claimed_string).getLargeIntValue();
+    task->setStatusMessage("Number of slot claims: " + slots_claimed_string);
 
-      // Fetch difficulties.
-      s = contract->call("getDifficulties", params);
-      if (!s.is_ok() || task->threadShouldExit()) {
-        std::cout << "ERROR: " << s.msg << std::endl;
-        task->logStatus(s, "getDifficulties");
-        return false;
+    bool incremental = false;
+    uint64 newTakeOvers = 0;
+    std::vector<uint64> claimTimes;
+    {
+      ScopedLock sl(m_criticalSection);
+      const auto snapshot = getSnapshot();
+      const auto now = Time::getCurrentTime().toMilliseconds();
+      incremental = !fullRefresh && m_isLoaded
+          && snapshot->slots.size() == static_cast<size_t>(slotsNumber)
+          && slotsClaimed >= snapshot->slotsClaimed
+          && now - m_lastFullReadTime < FULL_REFRESH_INTERVAL_MS;
+      if (incremental && slotsClaimed != snapshot->slotsClaimed) {
+        newTakeOvers = static_cast<uint64>(slotsClaimed - snapshot->slotsClaimed);
+        claimTimes.reserve(snapshot->slots.size());
+        for (size_t slot = 0; slot < snapshot->slots.size(); ++slot)
+          claimTimes.push_back(snapshot->slots.getClaimTime(slot));
       }
+    }
 
-      // Parse difficulties.
-      j_output = json::parse(s.msg);
-      std::vector<std::string> diff = (*j_output.begin()).get<std::vector<std::string> >();
-      for (uint32_t i = 0; i < diff.size(); i++) {
-        validatorSlots[slot + i].difficulty = dec_to_i256(false, diff[i]);
+    ValidatorSlots validatorSlots;
+    std::map<uint32_t, ValidatorSlot> changedSlots;
+    if (incremental) {
+      if (!claimTimes.empty()) {
+        s = readChangedSlots(this, task, claimTimes, newTakeOvers, &changedSlots);
+        if (!s.is_ok() || task->threadShouldExit())
+          return false;
+      } else {
+        task->setStatusMessage("Slots unchanged");
       }
-
-      // Fetch last claim times.
-      s = contract->call("getLastClaimTimes", params);
+    } else {
+      validatorSlots.resize(slotsNumber);
+
+      // Pages are read concurrently on pooled connections, eth_contract would serialize them on one.
+      const int pagesInFlight = static_cast<int>(
+          m_config.get_number(PAGES_IN_FLIGHT_FIELD, SlotPagesFetcher::DEFAULT_PAGES_IN_FLIGHT));
+      SlotPagesFetcher fetcher(getRpcClient(), contractAddress, getSlotsPager(url, SLOT_PAGES_PAGER), pagesInFlight);
+      s = fetcher.fetch(task, &validatorSlots);
       if (!s.is_ok() || task->threadShouldExit()) {
         std::cout << "ERROR: " << s.msg << std::endl;
-        task->logStatus(s, "getLastClaimTimes");
+        task->logStatus(s, "Slot pages");
         return false;
       }
-
-      // Parse last claim times.
-      j_output = json::parse(s.msg);
-      std::vector<std::string> last_claims = (*j_output.begin()).get<std::vector<std::string> >();
-      for (uint32_t i = 0; i < last_claims.size(); i++) {
-        validatorSlots[slot + i].last_claim_time = last_claims[i];
-      }
     }
     task->setProgress(0);
 
-    s = contract->call("mask", "");
+    s = call("mask", "");
     task->logStatus(s, "mask");
 
     j_output = json::parse(s.msg);
-    auto mask = bin2hex(dec_to_i256(false, (*j_output.begin()).get<std::string>()));
+    auto mask = parseContractUint((*j_output.begin()).get<std::string>()).toHex();
     task->setStatusMessage("Mask: " + mask);
 
-    s = contract->call("minDifficulty", "");
+    s = call("minDifficulty", "");
     task->logStatus(s, "minDifficulty");
     j_output = json::parse(s.msg);
-    auto minDifficulty = bin2hex(dec_to_i256(false, (*j_output.begin()).get<std::string>()));
+    auto minDifficulty = parseContractUint((*j_output.begin()).get<std::string>()).toHex();
     task->setStatusMessage("MinDifficulty: " + minDifficulty);
 
-    s = contract->call("proposalsData", "");
+    s = call("proposalsData", "");
     if (!s.is_ok() || task->threadShouldExit()) {
       task->logStatus(s, "proposalsData");
       return false;
@@ -202,28 +493,56 @@ bool AutomatonContractData::readContract() {
     j_output = json::parse(s.msg);
     ProposalThresholdData proposalThresholdData = {String(j_output[0].get<std::string>()).getLargeIntValue(),
                                                    String(j_output[1].get<std::string>()).getLargeIntValue()};
-
-    s = contract->call("numTakeOvers", "");
-    task->logStatus(s, "numTakeOvers");
-    j_output = json::parse(s.msg);
-    std::string slots_claimed_string = (*j_output.begin()).get<std::string>();
-    auto slotsClaimed = String(slots_claimed_string).getLargeIntValue();
-    task->setStatusMessage("Number of slot claims: " + slots_claimed_string);
     task->setProgress(1.0);
 
     if (task->threadShouldExit())
       return false;
 
     s = status::ok();
-    setData(url, contractAddress, mask, minDifficulty, slotsNumber, slotsClaimed,
-            proposalThresholdData, validatorSlots);
+    if (incremental) {
+      mergeData(mask, minDifficulty, slotsClaimed, proposalThresholdData, changedSlots, blockNumber);
+    } else {
+      setData(url, contractAddress, mask, minDifficulty, slotsNumber, slotsClaimed,
+              proposalThresholdData, std::move(validatorSlots), blockNumber);
+    }
+
+    const auto snapshot = getSnapshot();
+    if (!snapshot->changes.isEmpty()) {
+      int64 lastFullReadTime;
+      {
+        ScopedLock sl(m_criticalSection);
+        lastFullReadTime = m_lastFullReadTime;
+      }
+      m_cache->storeSnapshot(snapshot, lastFullReadTime);
+    }
 
+    task->setStatusMessage("Call cache: " + m_callCache->getStats().toString());
     return true;
-  }, nullptr, "Reading Contract...");
+  }, [weak = std::weak_ptr<AutomatonContractData>(shared_from_this())](AsyncTask* task) {
+    // The read may finish after the contract data was released.
+    if (auto self = weak.lock())
+      self->finishRead(task->m_status);
+  }, "Reading Contract...");
 
   return true;
 }
 
+void AutomatonContractData::finishRead(const status& s) {
+  m_readInFlight = false;
+  m_lastReadTime = Time::getCurrentTime().toMilliseconds();
+
+  std::vector<ReadCallback> callbacks;
+  callbacks.swap(m_readCallbacks);
+  if (m_fullRefreshPending) {
+    m_fullRefreshPending = false;
+    readContract(true);
+    m_readCallbacks.swap(m_pendingCallbacks);
+  }
+
+  for (auto& callback : callbacks)
+    callback(s);
+}
+
 std::shared_ptr<eth_contract> AutomatonContractData::getContract() {
   return eth_contract::get_contract(getAddress());
 }
@@ -232,11 +551,149 @@ status AutomatonContractData::call(const std::string& f,
                                    const std::string& params,
                                    const std::string& privateKey,
                                    const std::string& value) {
+  const auto function = m_abi.getFunction(f);
+  std::string callData;
+  const bool useCallCache = !RpcRecorder::getInstance()->isActive();
+  const bool readOnly = privateKey.empty() && value.empty() && function != nullptr && function->readOnly;
+  if (readOnly && m_abi.encodeCall(f, params, &callData).is_ok()) {
+    const uint64 block = m_headBlock.load();
+    auto s = status::ok();
+    if (useCallCache && m_callCache->get(f, params, block, &s.msg)) {
+      RpcStats::getInstance()->recordCacheHit(f);
+      return s;
+    }
+
+    const double start = Time::getMillisecondCounterHiRes();
+    s = getRpcClient()->ethCall(getAddress(), callData);
+    const size_t resultSize = s.msg.size();
+    s = m_abi.decodeCallResult(f, s);
+    if (s.is_ok() && resultSize > 0 && useCallCache)
+      m_callCache->put(f, params, block, s.msg);
+    RpcStats::getInstance()->record(f, s.is_ok(), Time::getMillisecondCounterHiRes() - start,
+                                    callData.size(), resultSize);
+    return s;
+  }
+
+  // Recorded without the private key, replayed transactions are never sent.
+  auto recorder = RpcRecorder::getInstance();
+  const auto recordKey = "contract " + f + " " + params + " " + value;
+  if (recorder->isReplaying()) {
+    std::string response;
+    int64 id = 0;
+    const double start = Time::getMillisecondCounterHiRes();
+    auto s = recorder->replay(recordKey, &response, &id);
+    if (s.is_ok())
+      s.msg = response;
+    RpcStats::getInstance()->record(f, s.is_ok(), Time::getMillisecondCounterHiRes() - start,
+                                    params.size(), response.size());
+    if (!readOnly)
+      m_callCache->clear();
+    return s;
+  }
+
   ScopedLock sl(m_criticalSection);
-  if (auto contract = getContract())
-    return getContract()->call(f, params, privateKey, value);
+  auto contract = getContract();
+  if (contract == nullptr)
+    return status::internal("Contract is NULL.");
+
+  const double start = Time::getMillisecondCounterHiRes();
+  const auto s = contract->call(f, params, privateKey, value);
+  const double milliseconds = Time::getMillisecondCounterHiRes() - start;
+  // eth_contract doesn't tell what went over the wire, the params and result are the closest measure.
+  RpcStats::getInstance()->record(f, s.is_ok(), milliseconds, params.size(), s.msg.size());
+  if (recorder->isRecording())
+    recorder->record(recordKey, s, s.msg, 0, milliseconds);
+  // Our own transactions change the contract state.
+  if (!readOnly)
+    m_callCache->clear();
+  return s;
+}
+
+std::shared_ptr<JsonRpcClient> AutomatonContractData::getRpcClient() {
+  ScopedLock sl(m_criticalSection);
+  if (m_rpcClient == nullptr || m_rpcClient->getUrl() != m_ethUrl)
+    m_rpcClient = JsonRpcClient::getShared(m_ethUrl);
+  return m_rpcClient;
+}
+
+status AutomatonContractData::getBlockNumber(uint64* blockNumber) {
+  const auto s = getRpcClient()->blockNumber(blockNumber);
+  if (s.is_ok())
+    m_headBlock = *blockNumber;
+  return s;
+}
+
+ContractCallCache* AutomatonContractData::getCallCache() const noexcept {
+  return m_callCache.get();
+}
+
+std::vector<status> AutomatonContractData::callBatch(const std::vector<ContractCall>& calls) {
+  std::vector<status> results(calls.size(), status::internal("Not called"));
+  const bool useCallCache = !RpcRecorder::getInstance()->isActive();
+  std::vector<size_t> batched;
+  std::vector<std::string> data;
+  const uint64 block = m_headBlock.load();
+  for (size_t i = 0; i < calls.size(); ++i) {
+    const auto function = m_abi.getFunction(calls[i].function);
+    std::string callData;
+    if (function != nullptr && function->readOnly
+        && m_abi.encodeCall(calls[i].function, calls[i].params, &callData).is_ok()) {
+      auto cached = status::ok();
+      if (useCallCache && m_callCache->get(calls[i].function, calls[i].params, block, &cached.msg)) {
+        RpcStats::getInstance()->recordCacheHit(calls[i].function);
+        results[i] = cached;
+        continue;
+      }
+      batched.push_back(i);
+      data.push_back(callData);
+    } else {
+      results[i] = call(calls[i].function, calls[i].params);
+    }
+  }
+
+  auto client = getRpcClient();
+  const auto address = getAddress();
+  AdaptivePager::Options options;
+  options.initialSize = CALL_BATCH_SIZE;
+  options.minSize = 1;
+  options.maxSize = 1000;
+  const auto pager = AdaptivePager::getShared(client->getUrl(), CALL_BATCHES_PAGER, options);
+  std::vector<status> batchResults;
+  for (size_t first = 0; first < batched.size();) {
+    const size_t last = jmin(first + pager->getPageSize(), batched.size());
+    const std::vector<std::string> batchData(data.begin() + first, data.begin() + last);
+    const double start = Time::getMillisecondCounterHiRes();
+    const auto s = client->ethCallBatch(address, batchData, &batchResults);
+    const double milliseconds = Time::getMillisecondCounterHiRes() - start;
+    if (s.is_ok()) {
+      size_t responseBytes = 0;
+      for (const auto& batchResult : batchResults)
+        responseBytes += batchResult.msg.size();
+      pager->recordSuccess(static_cast<uint32_t>(last - first), milliseconds, responseBytes);
+    } else if (pager->recordFailure(static_cast<uint32_t>(last - first), s)) {
+      continue;
+    }
 
-  return status::internal("Contract is NULL.");
+    for (size_t j = first; j < last; ++j) {
+      const auto& contractCall = calls[batched[j]];
+      auto& result = results[batched[j]];
+      // Calls of a failed batch are sent again one by one, call() counts them.
+      if (!s.is_ok()) {
+        result = call(contractCall.function, contractCall.params);
+        continue;
+      }
+
+      // Empty results stay empty, like in call().
+      const auto& batchResult = batchResults[j - first];
+      result = m_abi.decodeCallResult(contractCall.function, batchResult);
+      if (result.is_ok() && !batchResult.msg.empty() && useCallCache)
+        m_callCache->put(contractCall.function, contractCall.params, block, result.msg);
+      RpcStats::getInstance()->record(contractCall.function, result.is_ok(), milliseconds,
+                                      data[j].size(), batchResult.is_ok() ? batchResult.msg.size() : 0);
+    }
+    first = last;
+  }
+  return results;
 }
 
 std::string AutomatonContractData::getAbi() {
@@ -252,6 +709,7 @@ bool AutomatonContractData::loadAbi() {
   }
 
   m_contractAbi = std::string(abi, file_size);
+  m_abi = ContractAbi(m_contractAbi);
   return true;
 }
 
@@ -266,33 +724,32 @@ std::string AutomatonContractData::getAddress() const noexcept {
 }
 
 std::string AutomatonContractData::getMask() const noexcept {
-  ScopedLock sl(m_criticalSection);
-  return m_mask;
+  return getSnapshot()->mask;
 }
 
 std::string AutomatonContractData::getMinDifficulty() const noexcept {
-  ScopedLock sl(m_criticalSection);
-  return m_minDifficulty;
+  return getSnapshot()->minDifficulty;
 }
 
 uint32_t AutomatonContractData::getSlotsNumber() const noexcept {
-  ScopedLock sl(m_criticalSection);
-  return m_slotsNumber;
+  return getSnapshot()->slotsNumber;
 }
 
 uint32_t AutomatonContractData::getSlotsClaimed() const noexcept {
-  ScopedLock sl(m_criticalSection);
-  return m_slotsClaimed;
+  return getSnapshot()->slotsClaimed;
 }
 
 ProposalThresholdData AutomatonContractData::getThresholdData() const noexcept {
-  ScopedLock sl(m_criticalSection);
-  return m_proposalThresholdData;
+  return getSnapshot()->thresholdData;
 }
 
-std::vector<ValidatorSlot> AutomatonContractData::getSlots() const {
-  ScopedLock sl(m_criticalSection);
-  return m_slots;
+std::shared_ptr<const ValidatorSlots> AutomatonContractData::getSlots() const {
+  const auto snapshot = getSnapshot();
+  return std::shared_ptr<const ValidatorSlots>(snapshot, &snapshot->slots);
+}
+
+ContractCache* AutomatonContractData::getCache() const noexcept {
+  return m_cache.get();
 }
 
 bool AutomatonContractData::isLoaded() const noexcept {
@@ -19,17 +19,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
 #include <Utils/TasksOwner.h>
 #include "../../JuceLibraryCode/JuceHeader.h"
 #include "../Config/Config.h"
+#include "ContractAbi.h"
+#include "ValidatorSlots.h"
 #include "../Login/AccountsModel.h"
 #include "automaton/core/interop/ethereum/eth_contract_curl.h"
 #include "automaton/core/common/status.h"
 
-struct ValidatorSlot {
-  std::string difficulty;
-  std::string owner;
-  std::string last_claim_time;
+struct ContractCall {
+  std::string function;
+  std::string params;
 };
 
 struct ProposalThresholdData {
@@ -37,9 +44,68 @@ struct ProposalThresholdData {
   int64 contestPercentage;
 };
 
-class AutomatonContractData : public ChangeBroadcaster, public TasksOwner {
+// What changed in a snapshot compared to the version before it. Default constructed, everything changed.
+struct ContractChanges {
+  enum Field {
+    MASK = 1,
+    MIN_DIFFICULTY = 2,
+    SLOTS_NUMBER = 4,
+    SLOTS_CLAIMED = 8,
+    THRESHOLDS = 16,
+    ALL_FIELDS = 31
+  };
+
+  int fields = ALL_FIELDS;
+  // When set every slot counts as changed and slots is empty.
+  bool allSlots = true;
+  SparseSet<int> slots;
+
+  bool hasField(Field field) const noexcept { return (fields & field) != 0; }
+  bool isEmpty() const noexcept { return fields == 0 && !allSlots && slots.isEmpty(); }
+};
+
+// Contract state as of one read. Published snapshots are never modified, so readers can keep one for as long as they
+// need a consistent view, without locking.
+struct ContractSnapshot {
+  using Ptr = std::shared_ptr<const ContractSnapshot>;
+
+  // Versions start at 1, readers that start from 0 see everything as changed first.
+  uint64 version = 1;
+  // Chain head when the read started, 0 if unknown. Calls read the latest block, so the state may include later
+  // blocks, but never misses changes up to this one.
+  uint64 blockNumber = 0;
+  std::string mask;
+  std::string minDifficulty;
+  uint32_t slotsNumber = 0;
+  uint32_t slotsClaimed = 0;
+  ProposalThresholdData thresholdData = {0, 0};
+  ValidatorSlots slots;
+  ContractChanges changes;
+
+  // Change notifications are coalesced, a reader that missed versions gets everything as changed.
+  ContractChanges getChangesSince(uint64 lastVersion) const {
+    return lastVersion + 1 == version ? changes : ContractChanges();
+  }
+};
+
+class ContractCache;
+class ContractCallCache;
+class JsonRpcClient;
+
+class AutomatonContractData : public ChangeBroadcaster
+                            , public TasksOwner
+                            , public std::enable_shared_from_this<AutomatonContractData> {
  public:
   using Ptr = std::shared_ptr<AutomatonContractData>;
+  using ReadCallback = std::function<void(const automaton::core::common::status&)>;
+
+  // Slots per page of the first bulk read from a node, later reads use the size that worked (see AdaptivePager).
+  static const uint32_t SLOTS_PAGE_SIZE = 1024;
+  // Incremental reads are trusted for this long, then all slots are read again.
+  static const int64 FULL_REFRESH_INTERVAL_MS = 10 * 60 * 1000;
+  // Larger callBatch() requests are split, nodes limit the size of batches. This is the first split, it then adapts to
+  // the node.
+  static const size_t CALL_BATCH_SIZE = 100;
 
   AutomatonContractData(const Config& config);
   ~AutomatonContractData();
@@ -50,15 +116,41 @@ class AutomatonContractData : public ChangeBroadcaster, public TasksOwner {
                uint32_t _slots_number,
                uint32_t _slots_claimed,
                const ProposalThresholdData& proposalThresholdData,
-               const std::vector<ValidatorSlot>& _slots);
+               ValidatorSlots _slots,
+               uint64 blockNumber = 0);
 
-  bool readContract();
+  // Unless fullRefresh is set, only the slots claimed since the last read are read again. The first call publishes
+  // the cached state of the last session before reading, if there is one. Nothing is read while the chain head is
+  // still the block of the current snapshot.
+  //
+  // Only one read runs at a time: calls during a read share its result, a full refresh requested during an
+  // incremental read runs right after it. Reads that aren't full refreshes are skipped within the contract's
+  // min_refresh_interval_ms (default 0) of the last read. Call from the message thread, onFinished is called there
+  // too.
+  bool readContract(bool fullRefresh = false, ReadCallback onFinished = nullptr);
   std::shared_ptr<automaton::core::interop::ethereum::eth_contract> getContract();
+  // Read-only functions are sent as eth_call on the pooled connections of getRpcClient(), transactions go through
+  // eth_contract, which signs them. Results of read-only functions are cached for the latest block number seen by
+  // getBlockNumber(), within the contract's call_cache_ttl_ms (default 15000, 0 disables the cache). Transactions
+  // clear the cache.
   automaton::core::common::status call(const std::string& f,
                                        const std::string& params,
                                        const std::string& privateKey = "",
                                        const std::string& value = "");
 
+  // Read-only calls sent as JSON-RPC batches instead of one request each. Every result is in the format call()
+  // returns, in the order of calls. Falls back to call() for other functions and when the node rejects the batch.
+  std::vector<automaton::core::common::status> callBatch(const std::vector<ContractCall>& calls);
+
+  // Latest block number, a single cheap request to tell whether anything can have changed.
+  automaton::core::common::status getBlockNumber(uint64* blockNumber);
+
+  // Read-only call results served from the cache, see call().
+  ContractCallCache* getCallCache() const noexcept;
+
+  // Connection pool of the node, shared with every other user of the same URL.
+  std::shared_ptr<JsonRpcClient> getRpcClient();
+
   bool loadAbi();
   std::string getAbi();
   std::string getUrl() const noexcept;
@@ -68,24 +160,55 @@ class AutomatonContractData : public ChangeBroadcaster, public TasksOwner {
   uint32_t getSlotsNumber() const noexcept;
   uint32_t getSlotsClaimed() const noexcept;
   ProposalThresholdData getThresholdData() const noexcept;
-  std::vector<ValidatorSlot> getSlots() const;
+  // Shares the slots of the current snapshot.
+  std::shared_ptr<const ValidatorSlots> getSlots() const;
   bool isLoaded() const noexcept;
+  // Cached state of this contract on disk, also holds the proposals and orders of the last session.
+  ContractCache* getCache() const noexcept;
+
+  // Latest published contract state, never blocks.
+  ContractSnapshot::Ptr getSnapshot() const;
 
   std::string m_contractAbi;
   std::string m_ethUrl;
   std::string m_contractAddress;
-  std::string m_mask;
-  std::string m_minDifficulty;
-  uint32_t m_slotsNumber;
-  uint32_t m_slotsClaimed;
-  ProposalThresholdData m_proposalThresholdData;
-  std::vector<ValidatorSlot> m_slots;
 
+  // Guards the connection settings and serializes writers of snapshots, readers of snapshots don't take it.
   CriticalSection m_criticalSection;
 
   Config& getConfig();
 
  private:
   bool m_isLoaded = false;
+  int64 m_lastFullReadTime = 0;
   Config m_config;
+  ContractAbi m_abi;
+  std::shared_ptr<JsonRpcClient> m_rpcClient;
+  std::unique_ptr<ContractCache> m_cache;
+  std::unique_ptr<ContractCallCache> m_callCache;
+  // Block the cached call results belong to, the latest one getBlockNumber() returned.
+  std::atomic<uint64> m_headBlock {0};
+
+  // Read coalescing state, only used on the message thread.
+  bool m_readInFlight = false;
+  bool m_readInFlightIsFull = false;
+  bool m_fullRefreshPending = false;
+  int64 m_lastReadTime = 0;
+  std::vector<ReadCallback> m_readCallbacks;
+  std::vector<ReadCallback> m_pendingCallbacks;
+  // Only accessed with std::atomic_load and std::atomic_store.
+  ContractSnapshot::Ptr m_snapshot;
+
+  bool loadCache();
+  void finishRead(const automaton::core::common::status& s);
+  // Must be called with m_criticalSection held.
+  void publishSnapshot(std::shared_ptr<ContractSnapshot> snapshot);
+
+  void mergeData(const std::string& _mask,
+                 const std::string& _min_difficulty,
+                 uint32_t _slots_claimed,
+                 const ProposalThresholdData& proposalThresholdData,
+                 const std::map<uint32_t, ValidatorSlot>& changedSlots,
+                 uint64 blockNumber);
+  void storeConfig(const ContractSnapshot& snapshot);
 };
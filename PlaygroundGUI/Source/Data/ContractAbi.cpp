@@ -0,0 +1,143 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <json.hpp>
+
+#include "ContractAbi.h"
+#include "JuceHeader.h"
+#include "automaton/core/interop/ethereum/eth_helper_functions.h"
+#include "automaton/core/crypto/cryptopp/Keccak_256_cryptopp.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+using automaton::core::interop::ethereum::decode;
+using automaton::core::interop::ethereum::encode;
+using automaton::core::crypto::cryptopp::Keccak_256_cryptopp;
+
+static json getTypes(const json& j_params) {
+  json j_types = json::array();
+  if (j_params.is_array()) {
+    for (const auto& j_param : j_params)
+      j_types.push_back(j_param.value("type", ""));
+  }
+  return j_types;
+}
+
+ContractAbi::ContractAbi(const std::string& abiJson) {
+  const json j_abi = json::parse(abiJson, nullptr, false);
+  if (!j_abi.is_array())
+    return;
+
+  Keccak_256_cryptopp hasher;
+  for (const auto& j_entry : j_abi) {
+    if (!j_entry.is_object() || j_entry.value("type", "function") != "function")
+      continue;
+
+    const auto name = j_entry.value("name", "");
+    // Overloads are not supported, the first declaration wins.
+    if (name.empty() || m_functions.count(name))
+      continue;
+
+    const auto inputTypes = getTypes(j_entry.value("inputs", json::array()));
+    std::string signature = name + "(";
+    for (size_t i = 0; i < inputTypes.size(); ++i)
+      signature += (i > 0 ? "," : "") + inputTypes[i].get<std::string>();
+    signature += ")";
+
+    uint8_t digest[32];
+    hasher.calculate_digest(reinterpret_cast<const uint8_t*>(signature.data()), signature.size(), digest);
+
+    const auto mutability = j_entry.value("stateMutability", "");
+    Function function;
+    function.selector = std::string(reinterpret_cast<const char*>(digest), 4);
+    function.inputTypes = inputTypes.dump();
+    function.outputTypes = getTypes(j_entry.value("outputs", json::array())).dump();
+    function.readOnly = j_entry.value("constant", false) || mutability == "view" || mutability == "pure";
+    m_functions[name] = function;
+    m_names[function.selector] = name;
+  }
+}
+
+const ContractAbi::Function* ContractAbi::getFunction(const std::string& name) const {
+  const auto it = m_functions.find(name);
+  return it != m_functions.end() ? &it->second : nullptr;
+}
+
+std::string ContractAbi::getFunctionName(const std::string& selector) const {
+  const auto it = m_names.find(selector);
+  return it != m_names.end() ? it->second : std::string();
+}
+
+status ContractAbi::encodeCall(const std::string& f, const std::string& params, std::string* data) const {
+  const auto function = getFunction(f);
+  if (function == nullptr)
+    return status::internal("Function " + f + " is not in the ABI.");
+
+  *data = function->selector;
+  if (function->inputTypes != "[]")
+    *data += encode(function->inputTypes, params);
+  return status::ok();
+}
+
+status ContractAbi::decodeOutput(const std::string& f, const std::string& data) const {
+  const auto function = getFunction(f);
+  if (function == nullptr)
+    return status::internal("Function " + f + " is not in the ABI.");
+
+  auto s = status::ok();
+  s.msg = decode(function->outputTypes, data);
+  return s;
+}
+
+status ContractAbi::decodeCallResult(const std::string& f, const status& result) const {
+  if (!result.is_ok() || result.msg.empty())
+    return result;
+  return decodeOutput(f, result.msg);
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class ContractAbiTest : public UnitTest {
+ public:
+  ContractAbiTest() : UnitTest("ContractAbi") {
+  }
+
+  void runTest() override {
+    const ContractAbi abi(R"([{"type": "function", "name": "numSlots", "inputs": [],
+                               "outputs": [{"name": "", "type": "uint256"}], "stateMutability": "view"}])");
+
+    beginTest("Call results");
+    expect(abi.decodeCallResult("numSlots", status::internal("reverted")).msg == "reverted");
+    expect(!abi.decodeCallResult("numSlots", status::internal("reverted")).is_ok());
+
+    const auto empty = abi.decodeCallResult("numSlots", status::ok());
+    expect(empty.is_ok());
+    expect(empty.msg.empty());
+
+    auto result = status::ok();
+    result.msg = std::string(31, '\0') + "\x05";
+    const auto decoded = abi.decodeCallResult("numSlots", result);
+    expect(decoded.is_ok());
+    expect(decoded.msg == abi.decodeOutput("numSlots", result.msg).msg);
+    expect(!decoded.msg.empty());
+  }
+};
+
+static ContractAbiTest test;
+#endif
@@ -0,0 +1,61 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "automaton/core/common/status.h"
+
+// Function table of a contract ABI, enough to encode calls and decode their output the same way eth_contract does,
+// for calls that are sent without it (e.g. in batches).
+class ContractAbi {
+ public:
+  struct Function {
+    std::string selector;     // First 4 bytes of the hash of the signature
+    std::string inputTypes;   // JSON arrays of type names, as expected by encode() and decode()
+    std::string outputTypes;
+    bool readOnly;
+  };
+
+  ContractAbi() = default;
+  explicit ContractAbi(const std::string& abiJson);
+
+  // nullptr if there is no such function.
+  const Function* getFunction(const std::string& name) const;
+
+  // Name of the function with the given 4 byte selector, empty if there is none.
+  std::string getFunctionName(const std::string& selector) const;
+
+  // params is the JSON array passed to eth_contract::call, empty for functions without parameters.
+  automaton::core::common::status encodeCall(const std::string& f, const std::string& params, std::string* data) const;
+
+  // On success the status message is the JSON array eth_contract::call would have returned.
+  automaton::core::common::status decodeOutput(const std::string& f, const std::string& data) const;
+
+  // decodeOutput() of a binary eth_call result. Failures are returned as they are, and so are empty results: an
+  // address without code returns no data, which is left empty like eth_contract does.
+  automaton::core::common::status decodeCallResult(const std::string& f,
+                                                   const automaton::core::common::status& result) const;
+
+ private:
+  std::map<std::string, Function> m_functions;
+  std::map<std::string, std::string> m_names;
+};
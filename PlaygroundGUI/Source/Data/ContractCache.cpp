@@ -0,0 +1,306 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <iostream>
+
+#include "ContractCache.h"
+#include "RpcRecorder.h"
+
+static const char CACHE_MAGIC[4] = {'A', 'C', 'S', 'C'};
+
+const uint32 ContractCache::FORMAT_VERSION;
+
+static void writeString(MemoryOutputStream* out, const std::string& s) {
+  out->writeInt(static_cast<int>(s.size()));
+  out->write(s.data(), s.size());
+}
+
+static void alignTo8(MemoryOutputStream* out) {
+  while (out->getPosition() % 8 != 0)
+    out->writeByte(0);
+}
+
+// Bounds checked reads from the mapped file. A read past the end fails it and all reads after it.
+class CacheReader {
+ public:
+  CacheReader(const void* data, size_t size) : m_data(static_cast<const char*>(data)), m_size(size) {
+  }
+
+  bool isOk() const noexcept {
+    return m_ok;
+  }
+
+  const char* read(size_t size) {
+    if (!m_ok || m_size - m_position < size) {
+      m_ok = false;
+      return nullptr;
+    }
+    const char* p = m_data + m_position;
+    m_position += size;
+    return p;
+  }
+
+  uint32 readUint32() {
+    const char* p = read(sizeof(uint32));
+    return p != nullptr ? ByteOrder::littleEndianInt(p) : 0;
+  }
+
+  uint64 readUint64() {
+    const char* p = read(sizeof(uint64));
+    return p != nullptr ? ByteOrder::littleEndianInt64(p) : 0;
+  }
+
+  std::string readString() {
+    const uint32 size = readUint32();
+    const char* p = read(size);
+    return p != nullptr ? std::string(p, size) : std::string();
+  }
+
+  void alignTo8() {
+    read((8 - m_position % 8) % 8);
+  }
+
+ private:
+  const char* m_data;
+  size_t m_size;
+  size_t m_position = 0;
+  bool m_ok = true;
+};
+
+ContractCache::ContractCache(const File& file, const std::string& url, const std::string& contractAddress)
+    : m_file(file)
+    , m_url(url)
+    , m_contractAddress(contractAddress) {
+}
+
+File ContractCache::getDefaultFile(const std::string& url, const std::string& contractAddress) {
+  const auto name = String(contractAddress).toLowerCase() + "-" + String::toHexString(String(url).hashCode64());
+  return File::getSpecialLocation(File::userApplicationDataDirectory)
+      .getChildFile("automaton")
+      .getChildFile("cache")
+      .getChildFile(name + ".bin");
+}
+
+std::shared_ptr<ContractSnapshot> ContractCache::load(int64* lastFullReadTime) {
+  if (RpcRecorder::getInstance()->isActive())
+    return nullptr;
+
+  MemoryMappedFile mapped(m_file, MemoryMappedFile::readOnly);
+  if (mapped.getData() == nullptr)
+    return nullptr;
+
+  CacheReader reader(mapped.getData(), mapped.getSize());
+  const char* magic = reader.read(sizeof(CACHE_MAGIC));
+  if (magic == nullptr || memcmp(magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+      || reader.readUint32() != FORMAT_VERSION
+      || reader.readString() != m_url
+      || reader.readString() != m_contractAddress)
+    return nullptr;
+
+  auto snapshot = std::make_shared<ContractSnapshot>();
+  const auto readTime = static_cast<int64>(reader.readUint64());
+  snapshot->blockNumber = reader.readUint64();
+  snapshot->slotsNumber = reader.readUint32();
+  snapshot->slotsClaimed = reader.readUint32();
+  snapshot->thresholdData.approvalPercentage = static_cast<int64>(reader.readUint64());
+  snapshot->thresholdData.contestPercentage = static_cast<int64>(reader.readUint64());
+  snapshot->mask = reader.readString();
+  snapshot->minDifficulty = reader.readString();
+
+  const size_t numSlots = reader.readUint32();
+  reader.alignTo8();
+  const char* claimTimes = reader.read(numSlots * sizeof(uint64));
+  const char* difficulties = reader.read(numSlots * ValidatorSlots::DIFFICULTY_SIZE);
+  const char* owners = reader.read(numSlots * ValidatorSlots::OWNER_SIZE);
+  if (!reader.isOk())
+    return nullptr;
+
+  snapshot->slots.resize(numSlots);
+  for (size_t i = 0; i < numSlots; ++i)
+    snapshot->slots.setClaimTime(i, ByteOrder::littleEndianInt64(claimTimes + i * sizeof(uint64)));
+  snapshot->slots.setDifficulties(reinterpret_cast<const unsigned char*>(difficulties));
+  snapshot->slots.setOwners(reinterpret_cast<const unsigned char*>(owners));
+
+  std::vector<CachedProposal> proposals;
+  const uint32 numProposals = reader.readUint32();
+  for (uint32 i = 0; i < numProposals && reader.isOk(); ++i) {
+    CachedProposal proposal;
+    proposal.id = reader.readUint64();
+    proposal.info = reader.readString();
+    proposal.data = reader.readString();
+    proposal.voteDifference = reader.readString();
+    proposal.ballotBox = reader.readString();
+    proposals.push_back(std::move(proposal));
+  }
+
+  std::vector<CachedOrder> orders;
+  const uint32 numOrders = reader.readUint32();
+  for (uint32 i = 0; i < numOrders && reader.isOk(); ++i) {
+    CachedOrder order;
+    order.id = reader.readUint64();
+    order.data = reader.readString();
+    orders.push_back(std::move(order));
+  }
+
+  if (!reader.isOk())
+    return nullptr;
+
+  ScopedLock sl(m_lock);
+  m_snapshot = snapshot;
+  m_lastFullReadTime = readTime;
+  m_proposals = std::move(proposals);
+  m_orders = std::move(orders);
+  *lastFullReadTime = readTime;
+  return snapshot;
+}
+
+void ContractCache::storeSnapshot(ContractSnapshot::Ptr snapshot, int64 lastFullReadTime) {
+  ScopedLock sl(m_lock);
+  m_snapshot = snapshot;
+  m_lastFullReadTime = lastFullReadTime;
+  save();
+}
+
+void ContractCache::storeProposals(std::vector<CachedProposal> proposals) {
+  ScopedLock sl(m_lock);
+  m_proposals = std::move(proposals);
+  save();
+}
+
+void ContractCache::storeOrders(std::vector<CachedOrder> orders) {
+  ScopedLock sl(m_lock);
+  m_orders = std::move(orders);
+  save();
+}
+
+std::vector<CachedProposal> ContractCache::getProposals() const {
+  ScopedLock sl(m_lock);
+  return m_proposals;
+}
+
+std::vector<CachedOrder> ContractCache::getOrders() const {
+  ScopedLock sl(m_lock);
+  return m_orders;
+}
+
+void ContractCache::save() {
+  // Replayed data must not overwrite the cache of real sessions.
+  if (m_snapshot == nullptr || RpcRecorder::getInstance()->isActive())
+    return;
+
+  const auto& slots = m_snapshot->slots;
+  MemoryOutputStream out(64 + slots.size() * (sizeof(uint64) + ValidatorSlots::DIFFICULTY_SIZE
+                                               + ValidatorSlots::OWNER_SIZE));
+  out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  out.writeInt(static_cast<int>(FORMAT_VERSION));
+  writeString(&out, m_url);
+  writeString(&out, m_contractAddress);
+  out.writeInt64(m_lastFullReadTime);
+  out.writeInt64(static_cast<int64>(m_snapshot->blockNumber));
+  out.writeInt(static_cast<int>(m_snapshot->slotsNumber));
+  out.writeInt(static_cast<int>(m_snapshot->slotsClaimed));
+  out.writeInt64(m_snapshot->thresholdData.approvalPercentage);
+  out.writeInt64(m_snapshot->thresholdData.contestPercentage);
+  writeString(&out, m_snapshot->mask);
+  writeString(&out, m_snapshot->minDifficulty);
+
+  out.writeInt(static_cast<int>(slots.size()));
+  alignTo8(&out);
+  for (size_t i = 0; i < slots.size(); ++i)
+    out.writeInt64(static_cast<int64>(slots.getClaimTime(i)));
+  out.write(slots.getDifficulties(), slots.size() * ValidatorSlots::DIFFICULTY_SIZE);
+  out.write(slots.getOwners(), slots.size() * ValidatorSlots::OWNER_SIZE);
+
+  out.writeInt(static_cast<int>(m_proposals.size()));
+  for (const auto& proposal : m_proposals) {
+    out.writeInt64(static_cast<int64>(proposal.id));
+    writeString(&out, proposal.info);
+    writeString(&out, proposal.data);
+    writeString(&out, proposal.voteDifference);
+    writeString(&out, proposal.ballotBox);
+  }
+
+  out.writeInt(static_cast<int>(m_orders.size()));
+  for (const auto& order : m_orders) {
+    out.writeInt64(static_cast<int64>(order.id));
+    writeString(&out, order.data);
+  }
+
+  // Written next to the file and moved over it, so a crash never leaves a half written cache.
+  if (m_file.getParentDirectory().createDirectory().failed()) {
+    std::cout << "Failed to create cache directory " << m_file.getParentDirectory().getFullPathName() << std::endl;
+    return;
+  }
+  TemporaryFile temp(m_file);
+  if (!temp.getFile().replaceWithData(out.getData(), out.getDataSize()) || !temp.overwriteTargetFileWithTemporary())
+    std::cout << "Failed to write cache file " << m_file.getFullPathName() << std::endl;
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class ContractCacheTest : public UnitTest {
+ public:
+  ContractCacheTest() : UnitTest("ContractCache") {
+  }
+
+  void runTest() override {
+    beginTest("Round trip");
+    TemporaryFile temp(".bin");
+    auto snapshot = std::make_shared<ContractSnapshot>();
+    snapshot->mask = "ff00";
+    snapshot->minDifficulty = "00ff";
+    snapshot->slotsNumber = 3;
+    snapshot->slotsClaimed = 7;
+    snapshot->blockNumber = 123;
+    snapshot->thresholdData = {60, 40};
+    snapshot->slots.resize(3);
+    unsigned char difficulty[ValidatorSlots::DIFFICULTY_SIZE];
+    memset(difficulty, 0xAB, sizeof(difficulty));
+    snapshot->slots.setDifficulty(1, difficulty);
+    snapshot->slots.setClaimTime(2, 1234567890123ULL);
+    {
+      ContractCache cache(temp.getFile(), "url", "address");
+      cache.storeSnapshot(snapshot, 42);
+      cache.storeProposals({{100, "info", "data", "[\"1\"]", "box"}});
+      cache.storeOrders({{1, "order"}});
+    }
+
+    int64 lastFullReadTime = 0;
+    ContractCache cache(temp.getFile(), "url", "address");
+    const auto loaded = cache.load(&lastFullReadTime);
+    expect(loaded != nullptr);
+    expectEquals(lastFullReadTime, static_cast<int64>(42));
+    expect(loaded->mask == snapshot->mask && loaded->minDifficulty == snapshot->minDifficulty);
+    expectEquals(static_cast<int>(loaded->slotsClaimed), 7);
+    expect(loaded->blockNumber == 123);
+    expectEquals(loaded->thresholdData.contestPercentage, static_cast<int64>(40));
+    expect(loaded->slots.size() == 3);
+    for (size_t i = 0; i < 3; ++i)
+      expect(loaded->slots.isSameSlot(i, snapshot->slots));
+    expect(cache.getProposals().size() == 1 && cache.getProposals()[0].ballotBox == "box");
+    expect(cache.getOrders().size() == 1 && cache.getOrders()[0].data == "order");
+
+    beginTest("Other contracts are ignored");
+    ContractCache other(temp.getFile(), "url", "other");
+    expect(other.load(&lastFullReadTime) == nullptr);
+  }
+};
+
+static ContractCacheTest test;
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "JuceHeader.h"
+#include "AutomatonContractData.h"
+
+// Contract call results a proposal is built from, see ProposalsManager.
+struct CachedProposal {
+  uint64 id;
+  std::string info;
+  std::string data;
+  std::string voteDifference;
+  std::string ballotBox;
+};
+
+// getOrder result of a live order.
+struct CachedOrder {
+  uint64 id;
+  std::string data;
+};
+
+// Last known state of a contract on disk, one file per contract and RPC, so reopening an account shows it at once
+// while it is read again in the background.
+//
+// The file is little-endian binary: a header with the format version, the snapshot fields, the slots as the
+// fixed width arrays of ValidatorSlots (8 byte aligned, so load() copies them from the mapped file in one block each),
+// then proposals and orders. Files of other format versions or for other contracts are ignored.
+class ContractCache {
+ public:
+  static const uint32 FORMAT_VERSION = 2;
+
+  ContractCache(const File& file, const std::string& url, const std::string& contractAddress);
+
+  // <app data>/automaton/cache/<contract address>-<url hash>.bin
+  static File getDefaultFile(const std::string& url, const std::string& contractAddress);
+
+  // Returns nullptr if there is no usable cache file, or while RPC traffic is recorded or replayed. Proposals and
+  // orders are kept for getProposals() and getOrders().
+  std::shared_ptr<ContractSnapshot> load(int64* lastFullReadTime);
+
+  // Each store rewrites the file. Nothing is written before a snapshot was loaded or stored, or while RPC traffic is
+  // recorded or replayed.
+  void storeSnapshot(ContractSnapshot::Ptr snapshot, int64 lastFullReadTime);
+  void storeProposals(std::vector<CachedProposal> proposals);
+  void storeOrders(std::vector<CachedOrder> orders);
+
+  std::vector<CachedProposal> getProposals() const;
+  std::vector<CachedOrder> getOrders() const;
+
+ private:
+  File m_file;
+  std::string m_url;
+  std::string m_contractAddress;
+
+  CriticalSection m_lock;
+  ContractSnapshot::Ptr m_snapshot;
+  int64 m_lastFullReadTime = 0;
+  std::vector<CachedProposal> m_proposals;
+  std::vector<CachedOrder> m_orders;
+
+  // Must be called with m_lock held.
+  void save();
+
+  JUCE_DECLARE_NON_COPYABLE(ContractCache)
+};
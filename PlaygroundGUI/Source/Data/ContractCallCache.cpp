@@ -0,0 +1,153 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ContractCallCache.h"
+
+double ContractCallCache::Stats::getHitRate() const {
+  const auto lookups = hits + misses;
+  return lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups;
+}
+
+String ContractCallCache::Stats::toString() const {
+  return String(hits) + " hits, " + String(misses) + " misses (" + String(getHitRate() * 100.0, 1) + "%), "
+         + String(entries) + " entries, " + String(bytes) + " bytes";
+}
+
+ContractCallCache::ContractCallCache(size_t maxEntries, size_t maxBytes, int64 ttlMs)
+    : m_maxEntries(maxEntries)
+    , m_maxBytes(maxBytes)
+    , m_ttlMs(ttlMs) {
+}
+
+std::string ContractCallCache::getKey(const std::string& function, const std::string& params) {
+  std::string key;
+  key.reserve(function.size() + 1 + params.size());
+  key.append(function).append(1, '\0').append(params);
+  return key;
+}
+
+bool ContractCallCache::get(const std::string& function,
+                            const std::string& params,
+                            uint64 blockNumber,
+                            std::string* result,
+                            int64 nowMs) {
+  if (m_ttlMs <= 0)
+    return false;
+
+  const ScopedLock sl(m_lock);
+  auto it = m_index.find(getKey(function, params));
+  if (it == m_index.end() || it->second->blockNumber != blockNumber || nowMs - it->second->storedAt > m_ttlMs) {
+    ++m_misses;
+    return false;
+  }
+
+  m_entries.splice(m_entries.begin(), m_entries, it->second);
+  *result = it->second->result;
+  ++m_hits;
+  return true;
+}
+
+void ContractCallCache::put(const std::string& function,
+                            const std::string& params,
+                            uint64 blockNumber,
+                            const std::string& result,
+                            int64 nowMs) {
+  if (m_ttlMs <= 0)
+    return;
+
+  auto key = getKey(function, params);
+  const size_t bytes = key.size() + result.size();
+  if (bytes > m_maxBytes)
+    return;
+
+  const ScopedLock sl(m_lock);
+  auto it = m_index.find(key);
+  if (it != m_index.end())
+    erase(it->second);
+
+  m_entries.push_front({std::move(key), blockNumber, nowMs, result});
+  m_index[m_entries.front().key] = m_entries.begin();
+  m_bytes += bytes;
+
+  while (m_entries.size() > m_maxEntries || m_bytes > m_maxBytes)
+    erase(std::prev(m_entries.end()));
+}
+
+void ContractCallCache::erase(std::list<Entry>::iterator entry) {
+  m_bytes -= entry->key.size() + entry->result.size();
+  m_index.erase(entry->key);
+  m_entries.erase(entry);
+}
+
+void ContractCallCache::clear() {
+  const ScopedLock sl(m_lock);
+  m_entries.clear();
+  m_index.clear();
+  m_bytes = 0;
+}
+
+ContractCallCache::Stats ContractCallCache::getStats() const {
+  const ScopedLock sl(m_lock);
+  Stats stats;
+  stats.hits = m_hits;
+  stats.misses = m_misses;
+  stats.entries = m_entries.size();
+  stats.bytes = m_bytes;
+  return stats;
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class ContractCallCacheTest : public UnitTest {
+ public:
+  ContractCallCacheTest() : UnitTest("ContractCallCache") {
+  }
+
+  void runTest() override {
+    beginTest("Block and TTL");
+    ContractCallCache cache(2, 1024, 1000);
+    std::string result;
+    cache.put("mask", "", 10, "[\"1\"]", 0);
+    expect(cache.get("mask", "", 10, &result, 500) && result == "[\"1\"]");
+    expect(!cache.get("mask", "", 11, &result, 500));
+    expect(!cache.get("mask", "", 10, &result, 1500));
+    expect(!cache.get("mask", "[1]", 10, &result, 500));
+
+    beginTest("Limits");
+    cache.put("a", "", 10, "1", 0);
+    cache.put("b", "", 10, "2", 0);
+    expect(cache.get("a", "", 10, &result, 0));
+    cache.put("c", "", 10, "3", 0);
+    expect(cache.get("a", "", 10, &result, 0));
+    expect(!cache.get("b", "", 10, &result, 0));
+    expectEquals(static_cast<int>(cache.getStats().entries), 2);
+
+    ContractCallCache small(10, 8, 1000);
+    small.put("a", "", 10, std::string(16, 'x'), 0);
+    expect(!small.get("a", "", 10, &result, 0));
+
+    beginTest("Clear");
+    cache.clear();
+    expect(!cache.get("a", "", 10, &result, 0));
+    const auto stats = cache.getStats();
+    expect(stats.entries == 0 && stats.bytes == 0 && stats.hits == 3);
+  }
+};
+
+static ContractCallCacheTest test;
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "JuceHeader.h"
+
+// Results of read-only contract calls, so identical reads at the same block are sent once. An entry is keyed by
+// function and params and only returned for the block it was read at and within the TTL, the least recently used
+// entries are dropped beyond the entry and byte limits. Thread safe.
+class ContractCallCache {
+ public:
+  struct Stats {
+    uint64 hits = 0;
+    uint64 misses = 0;
+    size_t entries = 0;
+    size_t bytes = 0;
+
+    double getHitRate() const;
+    String toString() const;
+  };
+
+  // A ttlMs of 0 or less disables the cache.
+  ContractCallCache(size_t maxEntries, size_t maxBytes, int64 ttlMs);
+
+  bool get(const std::string& function,
+           const std::string& params,
+           uint64 blockNumber,
+           std::string* result,
+           int64 nowMs = Time::currentTimeMillis());
+  void put(const std::string& function,
+           const std::string& params,
+           uint64 blockNumber,
+           const std::string& result,
+           int64 nowMs = Time::currentTimeMillis());
+
+  // Drops all entries, e.g. after a transaction of our own. Keeps the statistics.
+  void clear();
+
+  Stats getStats() const;
+
+ private:
+  struct Entry {
+    std::string key;
+    uint64 blockNumber;
+    int64 storedAt;
+    std::string result;
+  };
+
+  size_t m_maxEntries;
+  size_t m_maxBytes;
+  int64 m_ttlMs;
+
+  CriticalSection m_lock;
+  // Most recently used first.
+  std::list<Entry> m_entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+  size_t m_bytes = 0;
+  uint64 m_hits = 0;
+  uint64 m_misses = 0;
+
+  static std::string getKey(const std::string& function, const std::string& params);
+  void erase(std::list<Entry>::iterator entry);
+
+  JUCE_DECLARE_NON_COPYABLE(ContractCallCache)
+};
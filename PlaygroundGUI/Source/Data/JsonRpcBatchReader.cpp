@@ -0,0 +1,208 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include "JsonRpcBatchReader.h"
+
+JsonRpcBatchReader::JsonRpcBatchReader(const char* text, size_t size) : m_pos(text), m_end(text + size) {
+}
+
+bool JsonRpcBatchReader::next(Response* response) {
+  if (m_failed || m_finished)
+    return false;
+
+  skipWhitespace();
+  if (!m_started) {
+    // Servers without batch support answer with a single error object.
+    if (!consume('['))
+      return fail();
+    m_started = true;
+    skipWhitespace();
+  } else if (!consume(',')) {
+    if (!consume(']'))
+      return fail();
+    m_finished = true;
+    return false;
+  }
+
+  skipWhitespace();
+  if (consume(']')) {
+    m_finished = true;
+    return false;
+  }
+
+  *response = Response();
+  if (!consume('{'))
+    return fail();
+  skipWhitespace();
+  if (consume('}'))
+    return true;
+
+  for (;;) {
+    skipWhitespace();
+    const char* key = m_pos;
+    if (!skipString())
+      return fail();
+    const size_t keySize = m_pos - key;
+
+    skipWhitespace();
+    if (!consume(':'))
+      return fail();
+    skipWhitespace();
+    const char* value = m_pos;
+    if (!skipValue())
+      return fail();
+    const size_t valueSize = m_pos - value;
+
+    if (keySize == 4 && memcmp(key, "\"id\"", 4) == 0) {
+      // Only integer ids are sent, anything else doesn't match a request.
+      int64 id = 0;
+      size_t i = 0;
+      while (i < valueSize && value[i] >= '0' && value[i] <= '9')
+        id = id * 10 + (value[i++] - '0');
+      response->hasId = i > 0 && i == valueSize;
+      response->id = id;
+    } else if (keySize == 8 && memcmp(key, "\"result\"", 8) == 0) {
+      response->result = value;
+      response->resultSize = valueSize;
+    } else if (keySize == 7 && memcmp(key, "\"error\"", 7) == 0) {
+      response->error = value;
+      response->errorSize = valueSize;
+    }
+
+    skipWhitespace();
+    if (consume('}'))
+      return true;
+    if (!consume(','))
+      return fail();
+  }
+}
+
+bool JsonRpcBatchReader::getPlainString(const char* value, size_t size, const char** chars, size_t* numChars) {
+  if (size < 2 || value[0] != '"' || value[size - 1] != '"' || memchr(value, '\\', size) != nullptr)
+    return false;
+
+  *chars = value + 1;
+  *numChars = size - 2;
+  return true;
+}
+
+void JsonRpcBatchReader::skipWhitespace() noexcept {
+  while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t'))
+    ++m_pos;
+}
+
+bool JsonRpcBatchReader::consume(char c) noexcept {
+  if (m_pos == m_end || *m_pos != c)
+    return false;
+
+  ++m_pos;
+  return true;
+}
+
+bool JsonRpcBatchReader::skipString() noexcept {
+  if (!consume('"'))
+    return false;
+
+  while (m_pos < m_end) {
+    const char c = *m_pos++;
+    if (c == '"')
+      return true;
+    if (c == '\\' && m_pos < m_end)
+      ++m_pos;
+  }
+  return false;
+}
+
+// Objects and arrays are only checked for balanced brackets, their contents aren't needed.
+bool JsonRpcBatchReader::skipValue() noexcept {
+  if (m_pos == m_end)
+    return false;
+
+  if (*m_pos == '"')
+    return skipString();
+
+  if (*m_pos == '{' || *m_pos == '[') {
+    int depth = 0;
+    while (m_pos < m_end) {
+      const char c = *m_pos;
+      if (c == '"') {
+        if (!skipString())
+          return false;
+        continue;
+      }
+      ++m_pos;
+      if (c == '{' || c == '[') {
+        ++depth;
+      } else if (c == '}' || c == ']') {
+        if (--depth == 0)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  // Numbers, true, false and null.
+  const char* start = m_pos;
+  while (m_pos < m_end && strchr(",}] \t\r\n", *m_pos) == nullptr)
+    ++m_pos;
+  return m_pos != start;
+}
+
+bool JsonRpcBatchReader::fail() noexcept {
+  m_failed = true;
+  return false;
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class JsonRpcBatchReaderTest : public UnitTest {
+ public:
+  JsonRpcBatchReaderTest() : UnitTest("JsonRpcBatchReader") {
+  }
+
+  void runTest() override {
+    beginTest("Results and errors");
+    const std::string text = "[ {\"jsonrpc\":\"2.0\",\"id\":7,\"result\":\"0x01ab\"},\n"
+                             "{\"id\": 8, \"error\": {\"code\": -32000, \"message\": \"a \\\"b\\\" }\"}} ]";
+    JsonRpcBatchReader reader(text.data(), text.size());
+    JsonRpcBatchReader::Response response;
+    expect(reader.next(&response));
+    expect(response.hasId && response.id == 7 && response.error == nullptr);
+    const char* chars = nullptr;
+    size_t numChars = 0;
+    expect(JsonRpcBatchReader::getPlainString(response.result, response.resultSize, &chars, &numChars));
+    expect(std::string(chars, numChars) == "0x01ab");
+
+    expect(reader.next(&response));
+    expect(response.hasId && response.id == 8 && response.result == nullptr);
+    expect(std::string(response.error, response.errorSize).find("message") != std::string::npos);
+    expect(!reader.next(&response));
+    expect(!reader.hasFailed());
+
+    beginTest("Not a batch");
+    const std::string single = "{\"id\":1,\"error\":{}}";
+    JsonRpcBatchReader singleReader(single.data(), single.size());
+    expect(!singleReader.next(&response));
+    expect(singleReader.hasFailed());
+  }
+};
+
+static JsonRpcBatchReaderTest test;
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "JuceHeader.h"
+
+// Walks a JSON-RPC batch response in place, one response object at a time, without building a JSON tree or copying
+// values. Meant for large responses where only the raw result text is needed, like pages of eth_call results.
+class JsonRpcBatchReader {
+ public:
+  // Values are the raw JSON text of the member, pointing into the response. Null if the member is missing.
+  struct Response {
+    bool hasId = false;
+    int64 id = 0;
+    const char* result = nullptr;
+    size_t resultSize = 0;
+    const char* error = nullptr;
+    size_t errorSize = 0;
+  };
+
+  JsonRpcBatchReader(const char* text, size_t size);
+
+  // Reads the next response of the batch. Returns false at the end of the batch, or when the text isn't a valid
+  // batch, see hasFailed().
+  bool next(Response* response);
+  bool hasFailed() const noexcept { return m_failed; }
+
+  // Characters of a JSON string value without its quotes, false if value isn't a string without escapes.
+  static bool getPlainString(const char* value, size_t size, const char** chars, size_t* numChars);
+
+ private:
+  const char* m_pos;
+  const char* m_end;
+  bool m_started = false;
+  bool m_finished = false;
+  bool m_failed = false;
+
+  void skipWhitespace() noexcept;
+  bool consume(char c) noexcept;
+  bool skipString() noexcept;
+  bool skipValue() noexcept;
+  bool fail() noexcept;
+};
@@ -0,0 +1,531 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <curl/curl.h>
+#include <json.hpp>
+#include <map>
+
+#include "JsonRpcClient.h"
+#include "JsonRpcBatchReader.h"
+#include "RpcEndpoint.h"
+#include "RpcRecorder.h"
+#include "RpcStats.h"
+#include "Config/Config.h"
+#include "automaton/core/io/io.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+using automaton::core::io::bin2hex;
+using automaton::core::io::hex2bin;
+
+static const char* const MAX_CONNECTIONS_FIELD = "rpc_max_connections";
+static const char* const HTTP2_FIELD = "rpc_http2";
+static const char* const HEDGE_PERCENTILE_FIELD = "rpc_hedge_percentile";
+static const char* const ENDPOINTS_FIELD = "rpc_endpoints";
+
+// Hedge delay while an endpoint has too few recent requests for a percentile, and the lower bound after.
+static const double DEFAULT_HEDGE_DELAY_MS = 500;
+static const double MIN_HEDGE_DELAY_MS = 10;
+// Endpoints are ejected after this many failures in a row, or when their median latency is this many times the
+// median of the best other endpoint.
+static const int MAX_CONSECUTIVE_FAILURES = 3;
+static const double MAX_SLOWDOWN = 3.0;
+static const double EJECT_MS = 30 * 1000;
+
+JsonRpcClient::JsonRpcClient(const std::vector<std::string>& urls, int maxConnections, bool http2, int hedgePercentile)
+    : m_hedgeFraction(jlimit(0, 100, hedgePercentile) / 100.0) {
+  jassert(!urls.empty());
+  for (const auto& url : urls)
+    m_endpoints.push_back(std::make_unique<RpcEndpoint>(url, maxConnections, http2));
+}
+
+JsonRpcClient::~JsonRpcClient() {
+}
+
+std::shared_ptr<JsonRpcClient> JsonRpcClient::getShared(const std::string& url) {
+  static CriticalSection clientsLock;
+  static std::map<std::string, std::weak_ptr<JsonRpcClient>> clients;
+
+  const ScopedLock sl(clientsLock);
+  auto& entry = clients[url];
+  if (auto client = entry.lock())
+    return client;
+
+  const auto config = ConfigFile::getInstance();
+  std::vector<std::string> urls = {url};
+  const auto equivalents = config->get_json(ENDPOINTS_FIELD);
+  if (equivalents.is_object() && equivalents.count(url) && equivalents[url].is_array()) {
+    for (const auto& equivalent : equivalents[url]) {
+      if (equivalent.is_string() && equivalent.get<std::string>() != url)
+        urls.push_back(equivalent.get<std::string>());
+    }
+  }
+
+  const int maxConnections = static_cast<int>(config->get_number(MAX_CONNECTIONS_FIELD, DEFAULT_MAX_CONNECTIONS));
+  const int hedgePercentile = static_cast<int>(config->get_number(HEDGE_PERCENTILE_FIELD, DEFAULT_HEDGE_PERCENTILE));
+  auto client = std::make_shared<JsonRpcClient>(urls, maxConnections, config->get_bool(HTTP2_FIELD, false),
+                                                hedgePercentile);
+  entry = client;
+  return client;
+}
+
+const std::string& JsonRpcClient::getUrl() const noexcept {
+  return m_endpoints.front()->getUrl();
+}
+
+RpcEndpoint* JsonRpcClient::pickEndpoint(const RpcEndpoint* exclude) const {
+  const double now = Time::getMillisecondCounterHiRes();
+  RpcEndpoint* best = nullptr;
+  double bestLatency = 0;
+  for (const auto& endpoint : m_endpoints) {
+    if (endpoint.get() == exclude || endpoint->isEjected(now))
+      continue;
+
+    // Endpoints without enough recent requests count as fastest, so new and returning endpoints get measured.
+    const double latency = jmax(0.0, endpoint->getLatencyPercentile(0.5));
+    if (best == nullptr || latency < bestLatency) {
+      best = endpoint.get();
+      bestLatency = latency;
+    }
+  }
+
+  if (best != nullptr || exclude != nullptr)
+    return best;
+
+  // Everything is ejected, the endpoint that returns first is the best bet.
+  for (const auto& endpoint : m_endpoints) {
+    if (best == nullptr || endpoint->getEjectedUntil() < best->getEjectedUntil())
+      best = endpoint.get();
+  }
+  return best;
+}
+
+double JsonRpcClient::getHedgeDelay(const RpcEndpoint* endpoint) const {
+  const double latency = endpoint->getLatencyPercentile(m_hedgeFraction);
+  return latency < 0 ? DEFAULT_HEDGE_DELAY_MS : jmax(MIN_HEDGE_DELAY_MS, latency);
+}
+
+void JsonRpcClient::recordResult(RpcEndpoint* endpoint, bool succeeded, double milliseconds) {
+  endpoint->recordResult(succeeded, milliseconds);
+  if (m_endpoints.size() < 2)
+    return;
+
+  // Never eject the last endpoint that is still in use.
+  const double now = Time::getMillisecondCounterHiRes();
+  double bestOtherLatency = -1;
+  bool hasOther = false;
+  for (const auto& other : m_endpoints) {
+    if (other.get() == endpoint || other->isEjected(now))
+      continue;
+    hasOther = true;
+    const double latency = other->getLatencyPercentile(0.5);
+    if (latency >= 0 && (bestOtherLatency < 0 || latency < bestOtherLatency))
+      bestOtherLatency = latency;
+  }
+  if (!hasOther)
+    return;
+
+  bool eject = endpoint->getConsecutiveFailures() >= MAX_CONSECUTIVE_FAILURES;
+  if (!eject && succeeded && bestOtherLatency > 0) {
+    const double latency = endpoint->getLatencyPercentile(0.5);
+    eject = latency > MAX_SLOWDOWN * bestOtherLatency;
+  }
+
+  if (eject) {
+    DBG("Ejecting RPC endpoint " << endpoint->getUrl());
+    endpoint->eject(now + EJECT_MS);
+  }
+}
+
+status JsonRpcClient::post(const std::string& body, std::string* response) {
+  auto primary = pickEndpoint(nullptr);
+  auto secondary = m_endpoints.size() > 1 ? pickEndpoint(primary) : nullptr;
+  if (secondary != nullptr)
+    return postHedged(primary, secondary, body, response);
+
+  const double start = Time::getMillisecondCounterHiRes();
+  const auto s = primary->post(body, response);
+  recordResult(primary, s.is_ok(), Time::getMillisecondCounterHiRes() - start);
+  return s;
+}
+
+namespace {
+// A request in flight on one endpoint of a hedged post.
+struct HedgedAttempt {
+  RpcEndpoint* endpoint = nullptr;
+  void* handle = nullptr;
+  std::string response;
+  double start = 0;
+  bool started = false;
+  bool done = false;
+  status result = status::internal("Not sent");
+};
+}  // namespace
+
+// Both attempts run on one curl multi handle on the calling thread, so the secondary one costs no extra thread and the
+// one still running when the other answered is simply dropped.
+status JsonRpcClient::postHedged(RpcEndpoint* primary,
+                                 RpcEndpoint* secondary,
+                                 const std::string& body,
+                                 std::string* response) {
+  auto multi = curl_multi_init();
+  if (multi == nullptr)
+    return primary->post(body, response);
+
+  HedgedAttempt attempts[2];
+  attempts[0].endpoint = primary;
+  attempts[1].endpoint = secondary;
+  auto launch = [&](HedgedAttempt* attempt, bool wait) {
+    attempt->started = true;
+    attempt->start = Time::getMillisecondCounterHiRes();
+    attempt->handle = attempt->endpoint->acquireHandle(wait);
+    if (attempt->handle == nullptr) {
+      attempt->done = true;
+      attempt->result = status::internal("Could not create a connection.");
+      return;
+    }
+    attempt->endpoint->prepare(attempt->handle, body, &attempt->response);
+    curl_multi_add_handle(multi, attempt->handle);
+  };
+
+  const double start = Time::getMillisecondCounterHiRes();
+  const double hedgeDelay = m_hedgeFraction > 0 ? getHedgeDelay(primary) : -1;
+  launch(&attempts[0], true);
+
+  HedgedAttempt* winner = nullptr;
+  for (;;) {
+    int running = 0;
+    curl_multi_perform(multi, &running);
+    int queued = 0;
+    while (auto message = curl_multi_info_read(multi, &queued)) {
+      if (message->msg != CURLMSG_DONE)
+        continue;
+      for (auto& attempt : attempts) {
+        if (attempt.handle == message->easy_handle && !attempt.done) {
+          attempt.done = true;
+          attempt.result = RpcEndpoint::getResult(attempt.handle, message->data.result);
+          recordResult(attempt.endpoint, attempt.result.is_ok(), Time::getMillisecondCounterHiRes() - attempt.start);
+          if (attempt.result.is_ok() && winner == nullptr)
+            winner = &attempt;
+        }
+      }
+    }
+    if (winner != nullptr)
+      break;
+
+    // A failed primary is retried on the secondary right away, without waiting for the hedge delay.
+    const double elapsed = Time::getMillisecondCounterHiRes() - start;
+    if (!attempts[1].started && (attempts[0].done || (hedgeDelay >= 0 && elapsed >= hedgeDelay))) {
+      launch(&attempts[1], attempts[0].done);
+      if (!attempts[0].done && attempts[1].handle != nullptr)
+        m_hedgedRequests.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    if (attempts[0].done && attempts[1].done)
+      break;
+
+    int waitMs = 100;
+    if (!attempts[1].started && hedgeDelay >= 0)
+      waitMs = jlimit(1, 100, static_cast<int>(hedgeDelay - elapsed) + 1);
+    curl_multi_wait(multi, nullptr, 0, waitMs, nullptr);
+  }
+
+  for (auto& attempt : attempts) {
+    if (attempt.handle == nullptr)
+      continue;
+    // The attempt that lost took at least as long as the winner.
+    if (!attempt.done)
+      attempt.endpoint->recordResult(true, Time::getMillisecondCounterHiRes() - attempt.start);
+    curl_multi_remove_handle(multi, attempt.handle);
+    attempt.endpoint->releaseHandle(attempt.handle);
+  }
+  curl_multi_cleanup(multi);
+
+  if (winner == nullptr)
+    return attempts[0].result;
+
+  *response = std::move(winner->response);
+  return winner->result;
+}
+
+// Result or error of a single response object.
+static status parseResponse(const json& j_response) {
+  if (!j_response.is_object())
+    return status::internal("Invalid response: " + j_response.dump().substr(0, 256));
+
+  if (j_response.count("error")) {
+    const auto& j_error = j_response["error"];
+    return status::internal(j_error.is_object() ? j_error.value("message", j_error.dump()) : j_error.dump());
+  }
+
+  if (!j_response.count("result"))
+    return status::internal("No result in response: " + j_response.dump().substr(0, 256));
+
+  auto s = status::ok();
+  s.msg = j_response["result"].dump();
+  return s;
+}
+
+static json ethCallParams(const std::string& to, const std::string& data) {
+  return {
+    {{"to", to}, {"data", "0x" + bin2hex(data)}},
+    "latest"
+  };
+}
+
+// Turns the hex string result of eth_call into binary.
+static status parseEthCallResult(status s) {
+  if (!s.is_ok())
+    return s;
+
+  const json j_result = json::parse(s.msg, nullptr, false);
+  if (!j_result.is_string())
+    return status::internal("Invalid eth_call result: " + s.msg.substr(0, 256));
+
+  const auto& result = j_result.get_ref<const std::string&>();
+  if (result.size() < 2 || result.compare(0, 2, "0x") != 0)
+    return status::internal("Invalid eth_call result: " + result.substr(0, 256));
+
+  s.msg = hex2bin(result.substr(2));
+  return s;
+}
+
+status JsonRpcClient::request(const std::string& method, const std::string& params) {
+  json j_params = json::parse(params, nullptr, false);
+  if (j_params.is_discarded())
+    return status::internal("Invalid params: " + params);
+
+  int64 id = m_nextId++;
+  const json j_request = {
+    {"jsonrpc", "2.0"},
+    {"id", id},
+    {"method", method},
+    {"params", j_params}
+  };
+
+  const auto body = j_request.dump();
+  const double start = Time::getMillisecondCounterHiRes();
+  std::string response;
+  auto s = exchange({{method, params}}, body, &id, &response);
+  if (s.is_ok()) {
+    const json j_response = json::parse(response, nullptr, false);
+    s = j_response.is_discarded() ? status::internal("Invalid response: " + response.substr(0, 256))
+                                  : parseResponse(j_response);
+  }
+
+  RpcStats::getInstance()->record(method, s.is_ok(), Time::getMillisecondCounterHiRes() - start,
+                                  body.size(), response.size());
+  return s;
+}
+
+// Stats key of a batch, e.g. "eth_call batch".
+static std::string getBatchMethod(const std::vector<std::pair<std::string, std::string>>& requests) {
+  if (requests.empty())
+    return "batch";
+  for (const auto& request : requests) {
+    if (request.first != requests.front().first)
+      return "batch";
+  }
+  return requests.front().first + " batch";
+}
+
+status JsonRpcClient::sendBatch(const std::vector<std::pair<std::string, std::string>>& requests,
+                                int64* firstId,
+                                std::string* response) {
+  // Ids are consecutive, responses may come back in any order.
+  *firstId = m_nextId.fetch_add(static_cast<int64>(requests.size()));
+  json j_batch = json::array();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    json j_params = json::parse(requests[i].second, nullptr, false);
+    if (j_params.is_discarded())
+      return status::internal("Invalid params: " + requests[i].second);
+
+    j_batch.push_back({
+      {"jsonrpc", "2.0"},
+      {"id", *firstId + static_cast<int64>(i)},
+      {"method", requests[i].first},
+      {"params", j_params}
+    });
+  }
+
+  // Errors of single requests in the batch show up in the stats of the contract functions that sent them.
+  const auto body = j_batch.dump();
+  const double start = Time::getMillisecondCounterHiRes();
+  const auto s = exchange(requests, body, firstId, response);
+  RpcStats::getInstance()->record(getBatchMethod(requests), s.is_ok(), Time::getMillisecondCounterHiRes() - start,
+                                  body.size(), response->size());
+  return s;
+}
+
+status JsonRpcClient::exchange(const std::vector<std::pair<std::string, std::string>>& requests,
+                               const std::string& body,
+                               int64* firstId,
+                               std::string* response) {
+  auto recorder = RpcRecorder::getInstance();
+  const bool recording = recorder->isRecording();
+  if (!recording && !recorder->isReplaying())
+    return post(body, response);
+
+  // Ids differ between sessions, the key is what was asked.
+  std::string key;
+  for (const auto& request : requests)
+    key += request.first + " " + request.second + "\n";
+  if (!recording)
+    return recorder->replay(key, response, firstId);
+
+  const double start = Time::getMillisecondCounterHiRes();
+  const auto s = post(body, response);
+  recorder->record(key, s, *response, *firstId, Time::getMillisecondCounterHiRes() - start);
+  return s;
+}
+
+status JsonRpcClient::requestBatch(const std::vector<std::pair<std::string, std::string>>& requests,
+                                   std::vector<status>* results) {
+  results->clear();
+  if (requests.empty())
+    return status::ok();
+
+  int64 firstId = 0;
+  std::string response;
+  auto s = sendBatch(requests, &firstId, &response);
+  if (!s.is_ok())
+    return s;
+
+  // Servers without batch support answer with a single error object.
+  const json j_response = json::parse(response, nullptr, false);
+  if (j_response.is_discarded() || !j_response.is_array())
+    return status::internal("Invalid batch response: " + response.substr(0, 256));
+
+  results->assign(requests.size(), status::internal("No response in batch"));
+  for (const auto& j_item : j_response) {
+    if (!j_item.is_object() || !j_item.count("id") || !j_item["id"].is_number_integer())
+      continue;
+
+    const int64 index = j_item["id"].get<int64>() - firstId;
+    if (index >= 0 && index < static_cast<int64>(requests.size()))
+      (*results)[static_cast<size_t>(index)] = parseResponse(j_item);
+  }
+  return status::ok();
+}
+
+status JsonRpcClient::ethCall(const std::string& to, const std::string& data) {
+  return parseEthCallResult(request("eth_call", ethCallParams(to, data).dump()));
+}
+
+status JsonRpcClient::ethCallBatchStream(const std::string& to,
+                                         const std::vector<std::string>& data,
+                                         const EthCallResultHandler& onResult) {
+  if (data.empty())
+    return status::ok();
+
+  std::vector<std::pair<std::string, std::string>> requests;
+  requests.reserve(data.size());
+  for (const auto& callData : data)
+    requests.emplace_back("eth_call", ethCallParams(to, callData).dump());
+
+  int64 firstId = 0;
+  std::string response;
+  auto s = sendBatch(requests, &firstId, &response);
+  if (!s.is_ok())
+    return s;
+
+  std::vector<bool> received(data.size(), false);
+  JsonRpcBatchReader reader(response.data(), response.size());
+  JsonRpcBatchReader::Response item;
+  while (reader.next(&item)) {
+    const int64 index = item.id - firstId;
+    if (!item.hasId || index < 0 || index >= static_cast<int64>(data.size()))
+      continue;
+
+    // Errors are small, only they go through a JSON tree.
+    if (item.error != nullptr)
+      return parseResponse({{"error", json::parse(item.error, item.error + item.errorSize, nullptr, false)}});
+
+    const char* hex = nullptr;
+    size_t numDigits = 0;
+    if (!JsonRpcBatchReader::getPlainString(item.result, item.resultSize, &hex, &numDigits)
+        || numDigits < 2 || hex[0] != '0' || hex[1] != 'x')
+      return status::internal("Invalid eth_call result in batch response");
+
+    s = onResult(static_cast<size_t>(index), hex + 2, numDigits - 2);
+    if (!s.is_ok())
+      return s;
+    received[static_cast<size_t>(index)] = true;
+  }
+
+  if (reader.hasFailed())
+    return status::internal("Invalid batch response: " + response.substr(0, 256));
+  for (bool ok : received) {
+    if (!ok)
+      return status::internal("No response in batch");
+  }
+  return status::ok();
+}
+
+status JsonRpcClient::requestQuantity(const std::string& method, const std::string& params, Uint256* value) {
+  auto s = request(method, params);
+  if (!s.is_ok())
+    return s;
+
+  const json result = json::parse(s.msg, nullptr, false);
+  if (!result.is_string() || result.get<std::string>().compare(0, 2, "0x") != 0
+      || !Uint256::fromHex(result.get<std::string>(), value))
+    return status::internal("Invalid " + method + " result: " + s.msg.substr(0, 256));
+
+  return s;
+}
+
+status JsonRpcClient::blockNumber(uint64* number) {
+  Uint256 value;
+  auto s = requestQuantity("eth_blockNumber", "[]", &value);
+  if (s.is_ok())
+    *number = value.getWord(0);
+  return s;
+}
+
+status JsonRpcClient::getBalance(const std::string& address, Uint256* wei) {
+  return requestQuantity("eth_getBalance", json({address, "latest"}).dump(), wei);
+}
+
+status JsonRpcClient::getTransactionCount(const std::string& address, uint64* count) {
+  Uint256 value;
+  auto s = requestQuantity("eth_getTransactionCount", json({address, "latest"}).dump(), &value);
+  if (s.is_ok())
+    *count = value.getWord(0);
+  return s;
+}
+
+status JsonRpcClient::ethCallBatch(const std::string& to,
+                                   const std::vector<std::string>& data,
+                                   std::vector<status>* results) {
+  std::vector<std::pair<std::string, std::string>> requests;
+  requests.reserve(data.size());
+  for (const auto& callData : data)
+    requests.emplace_back("eth_call", ethCallParams(to, callData).dump());
+
+  auto s = requestBatch(requests, results);
+  if (!s.is_ok())
+    return s;
+
+  for (auto& result : *results)
+    result = parseEthCallResult(result);
+  return s;
+}
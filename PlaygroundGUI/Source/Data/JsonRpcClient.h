@@ -0,0 +1,128 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "JuceHeader.h"
+#include "Utils/Uint256.h"
+#include "automaton/core/common/status.h"
+
+class RpcEndpoint;
+
+// JSON-RPC over HTTP for read-only calls that don't need a registered eth_contract. Each endpoint keeps a small pool
+// of keep-alive connections, so concurrent requests don't queue on a single one (see RpcEndpoint).
+//
+// A client can send to several equivalent nodes. Each request goes to the endpoint with the lowest median latency.
+// When it hasn't answered within the hedge percentile of that endpoint's recent latencies, or failed, the same
+// request is sent to the next best endpoint as well and the first answer wins. Endpoints that keep failing or are
+// much slower than the others are ejected for a while. Only idempotent requests may be sent, any of them can be
+// sent twice.
+class JsonRpcClient {
+ public:
+  static const int DEFAULT_MAX_CONNECTIONS = 8;
+  static const int DEFAULT_HEDGE_PERCENTILE = 95;
+
+  // The first URL is the primary one. A hedgePercentile of 0 disables hedging, failed requests are still sent to the
+  // next best endpoint.
+  explicit JsonRpcClient(const std::vector<std::string>& urls,
+                         int maxConnections = DEFAULT_MAX_CONNECTIONS,
+                         bool http2 = false,
+                         int hedgePercentile = DEFAULT_HEDGE_PERCENTILE);
+  ~JsonRpcClient();
+
+  // The client of a node shared by everything in the app that talks to it, created on first use from the config
+  // file: rpc_max_connections and rpc_http2 for the connections, rpc_hedge_percentile, and rpc_endpoints, an object
+  // that maps a URL to the URLs of equivalent nodes. Released with its last user.
+  static std::shared_ptr<JsonRpcClient> getShared(const std::string& url);
+
+  // On success the status message is the JSON text of the result. Blocks while all connections are busy.
+  automaton::core::common::status request(const std::string& method, const std::string& params);
+
+  // Sends (method, params) requests as a single JSON-RPC batch. When the batch itself succeeded, results holds the
+  // outcome of each request in the order of requests.
+  automaton::core::common::status requestBatch(const std::vector<std::pair<std::string, std::string>>& requests,
+                                               std::vector<automaton::core::common::status>* results);
+
+  // eth_call on the latest block. data is the binary call data, on success the status message is the binary result.
+  automaton::core::common::status ethCall(const std::string& to, const std::string& data);
+  automaton::core::common::status ethCallBatch(const std::string& to,
+                                               const std::vector<std::string>& data,
+                                               std::vector<automaton::core::common::status>* results);
+
+  // Called with the index of the call and the hex digits of its result, without 0x. The digits point into the
+  // response and are only valid during the call. A failed status fails the whole batch.
+  using EthCallResultHandler = std::function<automaton::core::common::status(size_t index,
+                                                                             const char* hex,
+                                                                             size_t numDigits)>;
+
+  // ethCallBatch() for large results: the response is scanned in place and each result is handed to onResult
+  // as hex, without a JSON tree, copies or binary conversion in between.
+  automaton::core::common::status ethCallBatchStream(const std::string& to,
+                                                     const std::vector<std::string>& data,
+                                                     const EthCallResultHandler& onResult);
+
+  // Number of the latest block, the cheapest way to tell whether the chain state changed.
+  automaton::core::common::status blockNumber(uint64* number);
+
+  // Balance in wei and number of sent transactions (the next nonce) of an address at the latest block.
+  automaton::core::common::status getBalance(const std::string& address, Uint256* wei);
+  automaton::core::common::status getTransactionCount(const std::string& address, uint64* count);
+
+  // URL of the primary endpoint.
+  const std::string& getUrl() const noexcept;
+  // Number of requests that were sent to a second endpoint.
+  uint64 getHedgedRequests() const noexcept { return m_hedgedRequests.load(std::memory_order_relaxed); }
+
+ private:
+  std::vector<std::unique_ptr<RpcEndpoint>> m_endpoints;
+  double m_hedgeFraction;
+  std::atomic<int64> m_nextId {1};
+  std::atomic<uint64> m_hedgedRequests {0};
+
+  // Best endpoint that isn't ejected, other than exclude. Without exclude there always is one.
+  RpcEndpoint* pickEndpoint(const RpcEndpoint* exclude) const;
+  double getHedgeDelay(const RpcEndpoint* endpoint) const;
+  void recordResult(RpcEndpoint* endpoint, bool succeeded, double milliseconds);
+  automaton::core::common::status post(const std::string& body, std::string* response);
+  automaton::core::common::status postHedged(RpcEndpoint* primary,
+                                             RpcEndpoint* secondary,
+                                             const std::string& body,
+                                             std::string* response);
+  // Result of a request whose result is a hex quantity, e.g. eth_blockNumber.
+  automaton::core::common::status requestQuantity(const std::string& method, const std::string& params, Uint256* value);
+  // post() through the RpcRecorder, which records the exchange or answers it from a recording. When replaying,
+  // firstId is set to the id of the recorded request.
+  automaton::core::common::status exchange(const std::vector<std::pair<std::string, std::string>>& requests,
+                                           const std::string& body,
+                                           int64* firstId,
+                                           std::string* response);
+  // Posts requests as one batch with consecutive ids starting at firstId.
+  automaton::core::common::status sendBatch(const std::vector<std::pair<std::string, std::string>>& requests,
+                                            int64* firstId,
+                                            std::string* response);
+
+  JUCE_DECLARE_NON_COPYABLE(JsonRpcClient)
+};
@@ -0,0 +1,653 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <json.hpp>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "LocalContractModel.h"
+#include "automaton/core/io/io.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+using automaton::core::io::bin2hex;
+
+static const uint64 DAY = 24 * 60 * 60;
+static const int NUM_GENERATED_OWNERS = 256;
+
+enum ProposalState {
+  PROPOSAL_STARTED = 1,
+  PROPOSAL_COMPLETED = 5
+};
+
+enum OrderType {
+  ORDER_NONE = 0,
+  ORDER_BUY = 1,
+  ORDER_SELL = 2
+};
+
+static status revert(const std::string& reason) {
+  return status::internal("execution reverted: " + reason);
+}
+
+static status returnOutput(const std::string& output) {
+  auto s = status::ok();
+  s.msg = output;
+  return s;
+}
+
+static uint64 getUnixTime() {
+  return static_cast<uint64>(Time::currentTimeMillis() / 1000);
+}
+
+// splitmix64, the generated votes are a pure function of the seed, the proposal and the slot.
+static uint64 mix(uint64 x) {
+  x += 0x9E3779B97F4A7C15ULL;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+static std::string getRandomBytes(Random* random, size_t size) {
+  std::string bytes(size, '\0');
+  for (auto& byte : bytes)
+    byte = static_cast<char>(random->nextInt(256));
+  return bytes;
+}
+
+static Uint256 getWei(uint64 units, int decimals) {
+  Uint256 value(units);
+  value.multiplyByPowerOfTen(decimals);
+  return value;
+}
+
+// Arguments of a call, a 32 byte word each after the selector. Missing words read as zero.
+class CallArguments {
+ public:
+  explicit CallArguments(const std::string& data) : m_data(data) {
+  }
+
+  std::string getWord(size_t index) const {
+    const size_t offset = 4 + 32 * index;
+    if (offset + 32 > m_data.size())
+      return std::string(32, '\0');
+    return m_data.substr(offset, 32);
+  }
+
+  Uint256 getUint(size_t index) const {
+    return Uint256::fromBigEndian(getWord(index));
+  }
+
+  // Saturates at the largest uint64, so out of range values still fail the range checks.
+  uint64 getUint64(size_t index) const {
+    return toUint64(getUint(index));
+  }
+
+  std::string getAddress(size_t index) const {
+    return getWord(index).substr(12);
+  }
+
+  // string or bytes argument, through the offset in its head word.
+  std::string getBytes(size_t index) const {
+    const uint64 offset = getUint64(index);
+    if (offset > m_data.size() || 4 + offset + 32 > m_data.size())
+      return std::string();
+    const size_t start = static_cast<size_t>(4 + offset + 32);
+    const uint64 size = toUint64(Uint256::fromBigEndian(m_data.substr(start - 32, 32)));
+    if (size > m_data.size() - start)
+      return std::string();
+    return m_data.substr(start, static_cast<size_t>(size));
+  }
+
+ private:
+  const std::string& m_data;
+
+  static uint64 toUint64(const Uint256& value) {
+    if (value.getWord(1) != 0 || value.getWord(2) != 0 || value.getWord(3) != 0)
+      return std::numeric_limits<uint64>::max();
+    return value.getWord(0);
+  }
+};
+
+// Output value. Static values are encoded in the head, dynamic ones after all heads.
+struct AbiValue {
+  std::string data;
+  bool dynamic;
+};
+
+static std::string uintWord(uint64 value) {
+  return Uint256(value).toBigEndian();
+}
+
+static std::string intWord(int64 value) {
+  std::string word(32, value < 0 ? '\xFF' : '\0');
+  for (int i = 0; i < 8; ++i)
+    word[31 - i] = static_cast<char>((static_cast<uint64>(value) >> (8 * i)) & 0xFF);
+  return word;
+}
+
+static std::string addressWord(const std::string& address) {
+  return std::string(12, '\0') + address;
+}
+
+static AbiValue word(const std::string& data) {
+  return {data, false};
+}
+
+static AbiValue bytes(const std::string& data) {
+  std::string encoded = uintWord(data.size()) + data;
+  encoded.resize(32 + (data.size() + 31) / 32 * 32, '\0');
+  return {encoded, true};
+}
+
+// words holds count words of a dynamic array.
+static AbiValue array(const std::string& words, uint64 count) {
+  return {uintWord(count) + words, true};
+}
+
+static std::string encode(const std::vector<AbiValue>& values) {
+  std::string heads;
+  std::string tails;
+  const size_t headsSize = 32 * values.size();
+  for (const auto& value : values) {
+    if (value.dynamic) {
+      heads += uintWord(headsSize + tails.size());
+      tails += value.data;
+    } else {
+      heads += value.data;
+    }
+  }
+  return heads + tails;
+}
+
+// Zero value of every output, what the contract returns for missing entries.
+static std::string encodeZeros(const ContractAbi::Function& function) {
+  std::vector<AbiValue> values;
+  for (const auto& j_type : json::parse(function.outputTypes)) {
+    const auto type = j_type.get<std::string>();
+    const bool dynamic = type == "string" || type == "bytes" || type.back() == ']';
+    values.push_back(dynamic ? bytes("") : word(std::string(32, '\0')));
+  }
+  return encode(values);
+}
+
+static ContractAbi loadAbi() {
+  int size = 0;
+  const char* abi = BinaryData::getNamedResource("king_automaton_abi_json", size);
+  return abi != nullptr ? ContractAbi(std::string(abi, static_cast<size_t>(size))) : ContractAbi();
+}
+
+LocalContractModel::LocalContractModel(const Options& options)
+    : m_abi(loadAbi())
+    , m_options(options) {
+  m_options.numSlots = jmax(1, m_options.numSlots);
+  m_options.numProposals = jmax(0, m_options.numProposals);
+  m_options.numOrders = jmax(0, m_options.numOrders);
+
+  Random random(m_options.seed);
+  const auto now = getUnixTime();
+  const size_t numSlots = static_cast<size_t>(m_options.numSlots);
+
+  std::vector<std::string> owners;
+  for (int i = 0; i < NUM_GENERATED_OWNERS; ++i)
+    owners.push_back(getRandomBytes(&random, 20));
+
+  // 16 leading bits, about 65536 keys per claimable slot.
+  m_mask = getRandomBytes(&random, 32);
+  m_minDifficulty = std::string(32, '\0');
+  m_minDifficulty[0] = m_minDifficulty[1] = '\xFF';
+
+  // A quarter of the slots is still unclaimed.
+  m_owners.reserve(numSlots * 20);
+  m_difficulties.reserve(numSlots * 32);
+  m_lastClaimTimes.resize(numSlots, 0);
+  std::vector<bool> claimed(numSlots, false);
+  for (size_t slot = 0; slot < numSlots; ++slot) {
+    if (random.nextInt(4) == 0) {
+      m_owners.append(20, '\0');
+      m_difficulties += m_minDifficulty;
+      continue;
+    }
+
+    claimed[slot] = true;
+
+    auto difficulty = m_minDifficulty.substr(0, 2) + getRandomBytes(&random, 30);
+    difficulty[2] = static_cast<char>(difficulty[2] | 0x80);
+    m_owners += owners[static_cast<size_t>(random.nextInt(NUM_GENERATED_OWNERS))];
+    m_difficulties += difficulty;
+    m_lastClaimTimes[slot] = now - static_cast<uint64>(random.nextInt(static_cast<int>(30 * DAY)));
+    m_numTakeOvers += 1 + static_cast<uint64>(random.nextInt(3));
+  }
+
+  m_proposals.resize(static_cast<size_t>(m_options.numProposals));
+  for (size_t i = 0; i < m_proposals.size(); ++i) {
+    auto& proposal = m_proposals[i];
+    const uint64 id = FIRST_PROPOSAL_ID + i;
+    proposal.contributor = owners[static_cast<size_t>(random.nextInt(NUM_GENERATED_OWNERS))];
+    proposal.title = "Proposal " + std::to_string(id);
+    proposal.documentsLink = "https://example.com/proposals/" + std::to_string(id);
+    proposal.documentsHash = getRandomBytes(&random, 32);
+    proposal.budgetPeriodLen = 30 * DAY;
+    proposal.remainingPeriods = 1 + static_cast<uint64>(random.nextInt(12));
+    proposal.budgetPerPeriod = getWei(1000 * (1 + static_cast<uint64>(random.nextInt(100))), 18);
+    proposal.initialPeriod = 7 * DAY;
+    proposal.contestPeriod = 7 * DAY;
+    proposal.state = static_cast<uint64>(PROPOSAL_STARTED + random.nextInt(PROPOSAL_COMPLETED));
+    proposal.initialEndDate = now - 14 * DAY + static_cast<uint64>(random.nextInt(static_cast<int>(28 * DAY)));
+    proposal.contestEndDate = proposal.initialEndDate + proposal.contestPeriod;
+    proposal.nextPaymentDate = proposal.initialEndDate + proposal.budgetPeriodLen;
+    // One in ten proposals is still prepaying gas.
+    proposal.paidSlots = random.nextInt(10) == 0 ? static_cast<uint64>(random.nextInt(m_options.numSlots)) : numSlots;
+    proposal.participation = 20 + random.nextInt(71);
+    proposal.approval = random.nextInt(101);
+    for (size_t slot = 0; slot < numSlots; ++slot)
+      ++proposal.voteCounts[claimed[slot] ? getGeneratedVote(proposal, id, slot) : 0];
+  }
+
+  m_orders.resize(static_cast<size_t>(m_options.numOrders));
+  for (auto& order : m_orders) {
+    const uint64 amount = 1 + static_cast<uint64>(random.nextInt(10000));
+    order.autoAmount = getWei(amount, 18);
+    order.ethAmount = getWei(amount * (100 + static_cast<uint64>(random.nextInt(900))), 12);
+    order.owner = owners[static_cast<size_t>(random.nextInt(NUM_GENERATED_OWNERS))];
+    // Some orders were filled or cancelled already.
+    order.type = static_cast<uint8>(random.nextInt(10) == 0 ? ORDER_NONE : ORDER_BUY + random.nextInt(2));
+  }
+}
+
+std::string LocalContractModel::getOwner(uint64 slot) const {
+  return m_owners.substr(static_cast<size_t>(slot) * 20, 20);
+}
+
+uint8 LocalContractModel::getVote(const Proposal& proposal, uint64 id, uint64 slot) const {
+  const auto it = proposal.castVotes.find(slot);
+  if (it != proposal.castVotes.end())
+    return it->second;
+
+  return isClaimed(slot) ? getGeneratedVote(proposal, id, slot) : 0;
+}
+
+uint8 LocalContractModel::getGeneratedVote(const Proposal& proposal, uint64 id, uint64 slot) const {
+  const uint64 h = mix(static_cast<uint64>(m_options.seed) ^ (id << 32) ^ slot);
+  if (static_cast<int>(h % 100) >= proposal.participation)
+    return 0;
+  return static_cast<int>((h >> 8) % 100) < proposal.approval ? 1 : 2;
+}
+
+bool LocalContractModel::isClaimed(uint64 slot) const {
+  const char* owner = m_owners.data() + static_cast<size_t>(slot) * 20;
+  return std::any_of(owner, owner + 20, [](char c) { return c != 0; });
+}
+
+Uint256 LocalContractModel::getAutoBalance(const std::string& address) const {
+  // Every account starts with a million AUTO, enough to sell and pay for proposals.
+  const auto it = m_autoBalances.find(address);
+  return it != m_autoBalances.end() ? it->second : getWei(1000000, 18);
+}
+
+Uint256 LocalContractModel::getEthBalance(const std::string& address) const {
+  const auto it = m_ethBalances.find(address);
+  return it != m_ethBalances.end() ? it->second : Uint256();
+}
+
+LocalContractModel::Proposal* LocalContractModel::findProposal(uint64 id) {
+  if (id < FIRST_PROPOSAL_ID || id - FIRST_PROPOSAL_ID >= m_proposals.size())
+    return nullptr;
+  return &m_proposals[static_cast<size_t>(id - FIRST_PROPOSAL_ID)];
+}
+
+const LocalContractModel::Proposal* LocalContractModel::findProposal(uint64 id) const {
+  return const_cast<LocalContractModel*>(this)->findProposal(id);
+}
+
+LocalContractModel::Order* LocalContractModel::findOrder(uint64 id) {
+  if (id == 0 || id > m_orders.size())
+    return nullptr;
+  return &m_orders[static_cast<size_t>(id - 1)];
+}
+
+const LocalContractModel::Order* LocalContractModel::findOrder(uint64 id) const {
+  return const_cast<LocalContractModel*>(this)->findOrder(id);
+}
+
+status LocalContractModel::call(const std::string& data) const {
+  const auto name = data.size() >= 4 ? m_abi.getFunctionName(data.substr(0, 4)) : std::string();
+  const auto function = m_abi.getFunction(name);
+  if (function == nullptr)
+    return revert("unknown function");
+
+  const CallArguments args(data);
+  const uint64 numSlots = static_cast<uint64>(m_options.numSlots);
+  std::vector<AbiValue> output;
+
+  ScopedLock lock(m_lock);
+  if (name == "numSlots") {
+    output = {word(uintWord(numSlots))};
+  } else if (name == "numTakeOvers") {
+    output = {word(uintWord(m_numTakeOvers))};
+  } else if (name == "mask") {
+    output = {word(m_mask)};
+  } else if (name == "minDifficulty") {
+    output = {word(m_minDifficulty)};
+  } else if (name == "getOwners" || name == "getDifficulties" || name == "getLastClaimTimes") {
+    const uint64 start = std::min(args.getUint64(0), numSlots);
+    const uint64 length = std::min(args.getUint64(1), numSlots - start);
+    std::string words;
+    words.reserve(static_cast<size_t>(length) * 32);
+    for (uint64 slot = start; slot < start + length; ++slot) {
+      if (name == "getOwners")
+        words += addressWord(getOwner(slot));
+      else if (name == "getDifficulties")
+        words.append(m_difficulties, static_cast<size_t>(slot) * 32, 32);
+      else
+        words += uintWord(m_lastClaimTimes[static_cast<size_t>(slot)]);
+    }
+    output = {array(words, length)};
+  } else if (name == "getSlot" || name == "getSlotOwner" || name == "getSlotDifficulty"
+             || name == "getSlotLastClaimTime") {
+    const uint64 slot = args.getUint64(0);
+    if (slot >= numSlots)
+      return revert("invalid slot");
+    const auto owner = word(addressWord(getOwner(slot)));
+    const auto difficulty = word(m_difficulties.substr(static_cast<size_t>(slot) * 32, 32));
+    const auto lastClaimTime = word(uintWord(m_lastClaimTimes[static_cast<size_t>(slot)]));
+    if (name == "getSlot")
+      output = {owner, difficulty, lastClaimTime};
+    else
+      output = {name == "getSlotOwner" ? owner : name == "getSlotDifficulty" ? difficulty : lastClaimTime};
+  } else if (name == "proposalsData") {
+    output = {word(intWord(10)), word(intWord(-10)), word(uintWord(5)),
+              word(uintWord(FIRST_PROPOSAL_ID - 1 + m_proposals.size())), word(uintWord(10)), word(uintWord(0))};
+  } else if (name == "getProposalInfo" || name == "getProposalData" || name == "calcVoteDifference"
+             || name == "getBallotBox" || name == "getVote" || name == "getVoteCount" || name == "unpaidSlots") {
+    const uint64 id = args.getUint64(0);
+    const auto proposal = findProposal(id);
+    if (proposal == nullptr)
+      return returnOutput(encodeZeros(*function));
+
+    const auto& p = *proposal;
+    if (name == "getProposalInfo") {
+      output = {word(addressWord(p.contributor)), bytes(p.title), bytes(p.documentsLink), bytes(p.documentsHash),
+                word(uintWord(p.budgetPeriodLen)), word(p.budgetPerPeriod.toBigEndian()),
+                word(uintWord(p.initialPeriod)), word(uintWord(p.contestPeriod))};
+    } else if (name == "getProposalData") {
+      output = {word(uintWord(p.remainingPeriods)), word(uintWord(p.nextPaymentDate)), word(uintWord(p.state)),
+                word(uintWord(p.initialEndDate)), word(uintWord(p.contestEndDate)), array("", 0), word(uintWord(0))};
+    } else if (name == "calcVoteDifference") {
+      output = {word(intWord((p.voteCounts[1] - p.voteCounts[2]) * 100 / static_cast<int64>(numSlots)))};
+    } else if (name == "getBallotBox") {
+      output = {word(uintWord(p.state)), word(uintWord(2)), word(uintWord(p.paidSlots))};
+    } else if (name == "getVote") {
+      const uint64 slot = args.getUint64(1);
+      output = {word(uintWord(slot < numSlots ? getVote(p, id, slot) : 0))};
+    } else if (name == "getVoteCount") {
+      const uint64 choice = args.getUint64(1);
+      output = {word(uintWord(choice < 3 ? static_cast<uint64>(p.voteCounts[choice]) : 0))};
+    } else {
+      output = {word(uintWord(numSlots - p.paidSlots))};
+    }
+  } else if (name == "getOrdersLength") {
+    output = {word(uintWord(m_orders.size()))};
+  } else if (name == "getOrder") {
+    const auto order = findOrder(args.getUint64(0));
+    if (order == nullptr)
+      return returnOutput(encodeZeros(*function));
+    output = {word(order->autoAmount.toBigEndian()), word(order->ethAmount.toBigEndian()),
+              word(addressWord(order->owner)), word(uintWord(order->type))};
+  } else if (name == "balanceOf" || name == "balances") {
+    output = {word(getAutoBalance(args.getAddress(0)).toBigEndian())};
+  } else if (name == "getBalanceETH") {
+    output = {word(getEthBalance(args.getAddress(0)).toBigEndian())};
+  } else if (name == "decimals") {
+    output = {word(uintWord(18))};
+  } else {
+    return returnOutput(encodeZeros(*function));
+  }
+  return returnOutput(encode(output));
+}
+
+status LocalContractModel::transact(const std::string& sender, const std::string& data, const Uint256& value) {
+  // Plain transfers to the contract are accepted.
+  if (data.empty())
+    return status::ok();
+
+  const auto name = data.size() >= 4 ? m_abi.getFunctionName(data.substr(0, 4)) : std::string();
+  if (name.empty())
+    return revert("unknown function");
+
+  const CallArguments args(data);
+  const uint64 numSlots = static_cast<uint64>(m_options.numSlots);
+  const auto now = getUnixTime();
+
+  ScopedLock lock(m_lock);
+  if (name == "claimSlot") {
+    const auto publicKeyX = args.getWord(0);
+    const uint64 slot = Uint256::fromBigEndian(publicKeyX).mod(static_cast<uint32_t>(numSlots));
+    std::string difficulty(32, '\0');
+    for (size_t i = 0; i < difficulty.size(); ++i)
+      difficulty[i] = static_cast<char>(publicKeyX[i] ^ m_mask[i]);
+    const auto current = m_difficulties.substr(static_cast<size_t>(slot) * 32, 32);
+    if (Uint256::fromBigEndian(difficulty) <= Uint256::fromBigEndian(current))
+      return revert("difficulty too low");
+
+    m_owners.replace(static_cast<size_t>(slot) * 20, 20, sender);
+    m_difficulties.replace(static_cast<size_t>(slot) * 32, 32, difficulty);
+    m_lastClaimTimes[static_cast<size_t>(slot)] = now;
+    ++m_numTakeOvers;
+  } else if (name == "castVote") {
+    const uint64 id = args.getUint64(0);
+    const uint64 slot = args.getUint64(1);
+    const uint64 choice = args.getUint64(2);
+    auto proposal = findProposal(id);
+    if (proposal == nullptr || slot >= numSlots || choice > 2)
+      return revert("invalid vote");
+    if (getOwner(slot) != sender)
+      return revert("not the slot owner");
+
+    --proposal->voteCounts[getVote(*proposal, id, slot)];
+    ++proposal->voteCounts[choice];
+    proposal->castVotes[slot] = static_cast<uint8>(choice);
+  } else if (name == "createProposal") {
+    Proposal proposal;
+    proposal.contributor = args.getAddress(0);
+    proposal.title = args.getBytes(1);
+    proposal.documentsLink = args.getBytes(2);
+    proposal.documentsHash = args.getBytes(3);
+    proposal.budgetPeriodLen = args.getUint64(4);
+    proposal.remainingPeriods = args.getUint64(5);
+    proposal.budgetPerPeriod = args.getUint(6);
+    proposal.initialPeriod = 7 * DAY;
+    proposal.contestPeriod = 7 * DAY;
+    proposal.state = PROPOSAL_STARTED;
+    proposal.initialEndDate = now + proposal.initialPeriod;
+    proposal.contestEndDate = proposal.initialEndDate + proposal.contestPeriod;
+    proposal.nextPaymentDate = proposal.initialEndDate;
+    proposal.voteCounts[0] = static_cast<int64>(numSlots);
+    m_proposals.push_back(std::move(proposal));
+  } else if (name == "payForGas") {
+    auto proposal = findProposal(args.getUint64(0));
+    if (proposal == nullptr)
+      return revert("invalid proposal");
+    proposal->paidSlots = std::min(numSlots, proposal->paidSlots + std::min(args.getUint64(1), numSlots));
+  } else if (name == "claimReward") {
+    auto proposal = findProposal(args.getUint64(0));
+    const auto budget = args.getUint(1);
+    if (proposal == nullptr || proposal->contributor != sender)
+      return revert("not the contributor");
+    if (budget > proposal->budgetPerPeriod || proposal->remainingPeriods == 0)
+      return revert("budget exceeded");
+
+    auto balance = getAutoBalance(sender);
+    balance.add(budget);
+    m_autoBalances[sender] = balance;
+    --proposal->remainingPeriods;
+    proposal->nextPaymentDate += proposal->budgetPeriodLen;
+  } else if (name == "transfer") {
+    const auto to = args.getAddress(0);
+    const auto amount = args.getUint(1);
+    auto balance = getAutoBalance(sender);
+    if (!balance.subtract(amount))
+      return revert("insufficient balance");
+    m_autoBalances[sender] = balance;
+    auto toBalance = getAutoBalance(to);
+    toBalance.add(amount);
+    m_autoBalances[to] = toBalance;
+  } else if (name == "sell") {
+    Order order;
+    order.autoAmount = args.getUint(0);
+    order.ethAmount = args.getUint(1);
+    order.owner = sender;
+    order.type = ORDER_SELL;
+    auto balance = getAutoBalance(sender);
+    if (!balance.subtract(order.autoAmount))
+      return revert("insufficient balance");
+    m_autoBalances[sender] = balance;
+    m_orders.push_back(order);
+  } else if (name == "buy") {
+    Order order;
+    order.autoAmount = args.getUint(0);
+    order.ethAmount = value;
+    order.owner = sender;
+    order.type = ORDER_BUY;
+    m_orders.push_back(order);
+  } else if (name == "sellNow" || name == "buyNow") {
+    // The order is filled for the given amounts, a partial fill keeps the rest open.
+    auto order = findOrder(args.getUint64(0));
+    const auto autoAmount = args.getUint(1);
+    const auto ethAmount = name == "sellNow" ? args.getUint(2) : value;
+    if (order == nullptr || order->type != (name == "sellNow" ? ORDER_BUY : ORDER_SELL))
+      return revert("invalid order");
+    if (autoAmount > order->autoAmount || ethAmount > order->ethAmount)
+      return revert("amount exceeds the order");
+
+    const auto& autoSender = name == "sellNow" ? sender : order->owner;
+    const auto& autoReceiver = name == "sellNow" ? order->owner : sender;
+    const auto& ethReceiver = name == "sellNow" ? sender : order->owner;
+    // The AUTO of a sell order is already held by the contract.
+    if (name == "sellNow") {
+      auto balance = getAutoBalance(autoSender);
+      if (!balance.subtract(autoAmount))
+        return revert("insufficient balance");
+      m_autoBalances[autoSender] = balance;
+    }
+    auto autoBalance = getAutoBalance(autoReceiver);
+    autoBalance.add(autoAmount);
+    m_autoBalances[autoReceiver] = autoBalance;
+    auto ethBalance = getEthBalance(ethReceiver);
+    ethBalance.add(ethAmount);
+    m_ethBalances[ethReceiver] = ethBalance;
+
+    order->autoAmount.subtract(autoAmount);
+    order->ethAmount.subtract(ethAmount);
+    if (order->autoAmount.isZero())
+      order->type = ORDER_NONE;
+  } else if (name == "cancelOrder") {
+    auto order = findOrder(args.getUint64(0));
+    if (order == nullptr || order->type == ORDER_NONE || order->owner != sender)
+      return revert("not the order owner");
+
+    if (order->type == ORDER_SELL) {
+      auto balance = getAutoBalance(sender);
+      balance.add(order->autoAmount);
+      m_autoBalances[sender] = balance;
+    } else {
+      auto balance = getEthBalance(sender);
+      balance.add(order->ethAmount);
+      m_ethBalances[sender] = balance;
+    }
+    order->type = ORDER_NONE;
+  } else if (name == "withdraw") {
+    auto balance = getEthBalance(sender);
+    if (!balance.subtract(args.getUint(0)))
+      return revert("insufficient balance");
+    m_ethBalances[sender] = balance;
+  }
+  // Everything else is accepted without changing the state.
+  return status::ok();
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class LocalContractModelTest : public UnitTest {
+ public:
+  LocalContractModelTest() : UnitTest("LocalContractModel") {
+  }
+
+  void runTest() override {
+    LocalContractModel::Options options;
+    options.numSlots = 64;
+    options.numProposals = 2;
+    options.numOrders = 3;
+    LocalContractModel model(options);
+    m_abi = loadAbi();
+    const std::string sender(20, '\x11');
+    const std::string other(20, '\x22');
+
+    beginTest("Views");
+    expect(call(&model, "numSlots", "")[0] == "64");
+    expect(call(&model, "getOwners", "[0,64]")[0].size() == 64);
+    expect(call(&model, "proposalsData", "")[3] == "101");
+    expect(call(&model, "getOrdersLength", "")[0] == "3");
+
+    beginTest("Claim and vote");
+    // The inverted mask gives the largest possible difficulty, which wins any slot.
+    Uint256 mask;
+    expect(Uint256::fromDecimal(call(&model, "mask", "")[0].get<std::string>(), &mask));
+    auto publicKeyX = mask.toBigEndian();
+    for (auto& c : publicKeyX)
+      c = static_cast<char>(~c);
+    const uint64 slot = Uint256::fromBigEndian(publicKeyX).mod(64);
+    const auto hex = bin2hex(publicKeyX);
+    expect(transact(&model, sender, "claimSlot", json({hex, hex, "27", hex, hex}).dump()).is_ok());
+    const auto owner = call(&model, "getSlotOwner", json({slot}).dump())[0].get<std::string>();
+    expect(String(owner).endsWithIgnoreCase(String::repeatedString("11", 20)));
+
+    expect(transact(&model, sender, "castVote", json({100, slot, 1}).dump()).is_ok());
+    expect(call(&model, "getVote", json({100, slot}).dump())[0] == "1");
+    expect(!transact(&model, other, "castVote", json({100, slot, 2}).dump()).is_ok());
+
+    beginTest("Orders");
+    expect(transact(&model, sender, "sell", "[\"1000\",\"2000\"]").is_ok());
+    expect(call(&model, "getOrdersLength", "")[0] == "4");
+    expect(!transact(&model, other, "cancelOrder", "[4]").is_ok());
+    expect(transact(&model, sender, "cancelOrder", "[4]").is_ok());
+    expect(call(&model, "getOrder", "[4]")[3] == "0");
+  }
+
+ private:
+  ContractAbi m_abi;
+
+  json call(LocalContractModel* model, const std::string& f, const std::string& params) {
+    std::string data;
+    m_abi.encodeCall(f, params, &data);
+    const auto s = model->call(data);
+    return s.is_ok() ? json::parse(m_abi.decodeOutput(f, s.msg).msg) : json::array();
+  }
+
+  status transact(LocalContractModel* model, const std::string& sender, const std::string& f,
+                  const std::string& params) {
+    std::string data;
+    m_abi.encodeCall(f, params, &data);
+    return model->transact(sender, data, Uint256());
+  }
+};
+
+static LocalContractModelTest test;
+#endif
@@ -0,0 +1,116 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "JuceHeader.h"
+#include "ContractAbi.h"
+#include "Utils/Uint256.h"
+#include "automaton/core/common/status.h"
+
+// In-memory king_automaton contract for the local RPC stand-in (see LocalRpcServer). It answers the view functions
+// the app reads and applies the transactions it sends, with the ABI encoding of the deployed contract. The initial
+// slots, proposals and orders are generated from a seed, so runs with the same options see the same state.
+//
+// Transactions are applied as sent: signatures passed as arguments (claimSlot) are not checked and there is no gas.
+class LocalContractModel {
+ public:
+  struct Options {
+    int numSlots = 65536;
+    int numProposals = 1000;
+    int numOrders = 1000;
+    int64 seed = 1;
+  };
+
+  // Proposals start at this id, like the ballot boxes of the contract.
+  static const uint64 FIRST_PROPOSAL_ID = 100;
+
+  explicit LocalContractModel(const Options& options);
+
+  // data is the binary call data, selector first. On success the status message is the binary output.
+  automaton::core::common::status call(const std::string& data) const;
+
+  // Applies a transaction of sender (20 bytes) carrying value wei. Fails without changing the state when the
+  // contract would have reverted.
+  automaton::core::common::status transact(const std::string& sender, const std::string& data, const Uint256& value);
+
+ private:
+  struct Proposal {
+    std::string contributor;
+    std::string title;
+    std::string documentsLink;
+    std::string documentsHash;
+    uint64 budgetPeriodLen = 0;
+    uint64 remainingPeriods = 0;
+    Uint256 budgetPerPeriod;
+    uint64 initialPeriod = 0;
+    uint64 contestPeriod = 0;
+    uint64 state = 0;
+    uint64 initialEndDate = 0;
+    uint64 contestEndDate = 0;
+    uint64 nextPaymentDate = 0;
+    uint64 paidSlots = 0;
+    int participation = 0;  // Percentages of the generated votes
+    int approval = 0;
+    int64 voteCounts[3] = {0, 0, 0};
+    std::unordered_map<uint64, uint8> castVotes;
+  };
+
+  struct Order {
+    Uint256 autoAmount;
+    Uint256 ethAmount;
+    std::string owner;
+    uint8 type = 0;
+  };
+
+  ContractAbi m_abi;
+  Options m_options;
+  mutable CriticalSection m_lock;
+
+  std::string m_mask;
+  std::string m_minDifficulty;
+  uint64 m_numTakeOvers = 0;
+  std::string m_owners;        // 20 bytes per slot
+  std::string m_difficulties;  // 32 bytes per slot
+  std::vector<uint64> m_lastClaimTimes;
+
+  std::vector<Proposal> m_proposals;
+  std::vector<Order> m_orders;  // Order ids start at 1
+
+  std::unordered_map<std::string, Uint256> m_autoBalances;
+  std::unordered_map<std::string, Uint256> m_ethBalances;
+
+  std::string getOwner(uint64 slot) const;
+  bool isClaimed(uint64 slot) const;
+  uint8 getVote(const Proposal& proposal, uint64 id, uint64 slot) const;
+  // Vote of the generated state, before any castVote.
+  uint8 getGeneratedVote(const Proposal& proposal, uint64 id, uint64 slot) const;
+  Uint256 getAutoBalance(const std::string& address) const;
+  Uint256 getEthBalance(const std::string& address) const;
+  Proposal* findProposal(uint64 id);
+  const Proposal* findProposal(uint64 id) const;
+  Order* findOrder(uint64 id);
+  const Order* findOrder(uint64 id) const;
+
+  JUCE_DECLARE_NON_COPYABLE(LocalContractModel)
+};
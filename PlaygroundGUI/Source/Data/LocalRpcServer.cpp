@@ -0,0 +1,505 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <secp256k1_recovery.h>
+#include <memory>
+#include <vector>
+
+#include "LocalRpcServer.h"
+#include "automaton/core/crypto/cryptopp/Keccak_256_cryptopp.h"
+#include "automaton/core/io/io.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+using automaton::core::crypto::cryptopp::Keccak_256_cryptopp;
+using automaton::core::io::bin2hex;
+using automaton::core::io::hex2bin;
+
+const char* const LocalRpcServer::COMMAND_LINE_FLAG = "--rpc-standin";
+
+// Every connection keeps a pool thread while it is open.
+static const int MAX_CONNECTIONS = 64;
+static const int64 MAX_BODY_SIZE = 64 * 1024 * 1024;
+static const uint64 FIRST_BLOCK = 10000000;
+
+bool LocalRpcServer::isRequested(const StringArray& args) {
+  return args.contains(COMMAND_LINE_FLAG);
+}
+
+LocalRpcServer::Options LocalRpcServer::parseCommandLine(const StringArray& args) {
+  Options options;
+  for (int i = 0; i + 1 < args.size(); ++i) {
+    const int value = args[i + 1].getIntValue();
+    if (args[i] == "--port") {
+      options.port = value;
+    } else if (args[i] == "--slots") {
+      options.model.numSlots = jmax(1, value);
+    } else if (args[i] == "--proposals") {
+      options.model.numProposals = jmax(0, value);
+    } else if (args[i] == "--orders") {
+      options.model.numOrders = jmax(0, value);
+    } else if (args[i] == "--latency") {
+      options.latencyMs = jmax(0, value);
+    } else if (args[i] == "--jitter") {
+      options.jitterMs = jmax(0, value);
+    } else if (args[i] == "--block-time") {
+      options.blockTimeMs = jmax(1, value);
+    } else if (args[i] == "--seed") {
+      options.model.seed = args[i + 1].getLargeIntValue();
+    }
+  }
+  return options;
+}
+
+static std::string keccak(const std::string& data) {
+  Keccak_256_cryptopp hasher;
+  uint8_t digest[32];
+  hasher.calculate_digest(reinterpret_cast<const uint8_t*>(data.data()), data.size(), digest);
+  return std::string(reinterpret_cast<const char*>(digest), sizeof(digest));
+}
+
+static std::string toQuantity(const Uint256& value) {
+  const auto hex = value.toHex();
+  const auto first = hex.find_first_not_of('0');
+  return "0x" + (first == std::string::npos ? std::string("0") : hex.substr(first));
+}
+
+static std::string fromHexData(const std::string& hex) {
+  return hex2bin(hex.compare(0, 2, "0x") == 0 ? hex.substr(2) : hex);
+}
+
+// Reads the RLP item at *pos into payload and advances *pos past it.
+static bool readRlpItem(const std::string& data, size_t* pos, std::string* payload, bool* isList) {
+  if (*pos >= data.size())
+    return false;
+
+  const uint8 prefix = static_cast<uint8>(data[*pos]);
+  size_t offset = 1;
+  size_t length = 0;
+  *isList = prefix >= 0xC0;
+  if (prefix < 0x80) {
+    offset = 0;
+    length = 1;
+  } else if (prefix <= 0xB7 || (prefix >= 0xC0 && prefix <= 0xF7)) {
+    length = prefix - (*isList ? 0xC0 : 0x80);
+  } else {
+    const size_t lengthSize = prefix - (*isList ? 0xF7 : 0xB7);
+    if (lengthSize > 4 || *pos + 1 + lengthSize > data.size())
+      return false;
+    for (size_t i = 0; i < lengthSize; ++i)
+      length = (length << 8) | static_cast<uint8>(data[*pos + 1 + i]);
+    offset += lengthSize;
+  }
+
+  if (offset + length > data.size() - *pos)
+    return false;
+  payload->assign(data, *pos + offset, length);
+  *pos += offset + length;
+  return true;
+}
+
+static std::string encodeRlp(const std::string& payload, bool isList) {
+  if (!isList && payload.size() == 1 && static_cast<uint8>(payload[0]) < 0x80)
+    return payload;
+
+  const int base = isList ? 0xC0 : 0x80;
+  if (payload.size() < 56)
+    return std::string(1, static_cast<char>(base + payload.size())) + payload;
+
+  std::string length;
+  for (size_t n = payload.size(); n > 0; n >>= 8)
+    length.insert(0, 1, static_cast<char>(n & 0xFF));
+  return std::string(1, static_cast<char>(base + 55 + length.size())) + length + payload;
+}
+
+static uint64 toUint64(const std::string& bigEndian) {
+  uint64 value = 0;
+  for (const auto c : bigEndian)
+    value = (value << 8) | static_cast<uint8>(c);
+  return value;
+}
+
+// Signed legacy transaction, with or without EIP-155 replay protection.
+struct SignedTransaction {
+  std::string sender;
+  std::string to;
+  std::string data;
+  Uint256 value;
+};
+
+static bool decodeTransaction(const std::string& raw, SignedTransaction* transaction) {
+  size_t pos = 0;
+  std::string list;
+  bool isList = false;
+  if (!readRlpItem(raw, &pos, &list, &isList) || !isList)
+    return false;
+
+  std::vector<std::string> fields;
+  for (size_t listPos = 0; listPos < list.size();) {
+    std::string field;
+    if (!readRlpItem(list, &listPos, &field, &isList) || isList)
+      return false;
+    fields.push_back(field);
+  }
+  // nonce, gasPrice, gasLimit, to, value, data, v, r, s
+  if (fields.size() != 9 || fields[4].size() > 32 || fields[6].size() > 8 || fields[7].size() > 32
+      || fields[8].size() > 32)
+    return false;
+
+  std::string signedFields;
+  for (size_t i = 0; i < 6; ++i)
+    signedFields += encodeRlp(fields[i], false);
+
+  const uint64 v = toUint64(fields[6]);
+  int recoveryId = 0;
+  if (v >= 35) {
+    std::string chainId;
+    for (uint64 n = (v - 35) / 2; n > 0; n >>= 8)
+      chainId.insert(0, 1, static_cast<char>(n & 0xFF));
+    signedFields += encodeRlp(chainId, false) + encodeRlp("", false) + encodeRlp("", false);
+    recoveryId = static_cast<int>((v - 35) % 2);
+  } else if (v == 27 || v == 28) {
+    recoveryId = static_cast<int>(v - 27);
+  } else {
+    return false;
+  }
+
+  const auto hash = keccak(encodeRlp(signedFields, true));
+  const auto signature = std::string(32 - fields[7].size(), '\0') + fields[7]
+                         + std::string(32 - fields[8].size(), '\0') + fields[8];
+
+  // Recovery only reads the context, one is shared by all connections.
+  static secp256k1_context* context = secp256k1_context_create(SECP256K1_CONTEXT_VERIFY);
+  secp256k1_ecdsa_recoverable_signature recoverable;
+  secp256k1_pubkey publicKey;
+  if (!secp256k1_ecdsa_recoverable_signature_parse_compact(context, &recoverable,
+          reinterpret_cast<const unsigned char*>(signature.data()), recoveryId)
+      || !secp256k1_ecdsa_recover(context, &publicKey, &recoverable,
+                                  reinterpret_cast<const unsigned char*>(hash.data())))
+    return false;
+
+  unsigned char serialized[65];
+  size_t serializedSize = sizeof(serialized);
+  secp256k1_ec_pubkey_serialize(context, serialized, &serializedSize, &publicKey, SECP256K1_EC_UNCOMPRESSED);
+
+  transaction->sender = keccak(std::string(reinterpret_cast<const char*>(serialized + 1), 64)).substr(12);
+  transaction->to = fields[3];
+  transaction->value = Uint256::fromBigEndian(fields[4]);
+  transaction->data = fields[5];
+  return true;
+}
+
+static json makeError(const json& id, int code, const std::string& message) {
+  return {{"jsonrpc", "2.0"}, {"id", id}, {"error", {{"code", code}, {"message", message}}}};
+}
+
+// Serves the requests of one keep-alive connection until the client closes it or the server stops.
+class LocalRpcServer::Connection : public ThreadPoolJob {
+ public:
+  Connection(LocalRpcServer* server, StreamingSocket* socket)
+      : ThreadPoolJob("RPC connection")
+      , m_server(server)
+      , m_socket(socket) {
+  }
+
+  JobStatus runJob() override {
+    std::string buffer;
+    while (!shouldExit()) {
+      size_t headerEnd;
+      while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+        if (!receive(&buffer))
+          return jobHasFinished;
+      }
+
+      const auto lines = StringArray::fromLines(String(buffer.substr(0, headerEnd)));
+      int64 contentLength = 0;
+      bool keepAlive = !lines[0].endsWith("HTTP/1.0");
+      bool expectContinue = false;
+      for (int i = 1; i < lines.size(); ++i) {
+        const auto name = lines[i].upToFirstOccurrenceOf(":", false, false).trim();
+        const auto value = lines[i].fromFirstOccurrenceOf(":", false, false).trim();
+        if (name.equalsIgnoreCase("Content-Length"))
+          contentLength = value.getLargeIntValue();
+        else if (name.equalsIgnoreCase("Connection"))
+          keepAlive = value.equalsIgnoreCase("keep-alive");
+        else if (name.equalsIgnoreCase("Expect"))
+          expectContinue = value.equalsIgnoreCase("100-continue");
+      }
+      if (contentLength < 0 || contentLength > MAX_BODY_SIZE)
+        return jobHasFinished;
+
+      const size_t requestSize = headerEnd + 4 + static_cast<size_t>(contentLength);
+      if (expectContinue && buffer.size() < requestSize && !send("HTTP/1.1 100 Continue\r\n\r\n"))
+        return jobHasFinished;
+      while (buffer.size() < requestSize) {
+        if (!receive(&buffer))
+          return jobHasFinished;
+      }
+
+      const auto body = buffer.substr(headerEnd + 4, static_cast<size_t>(contentLength));
+      buffer.erase(0, requestSize);
+
+      const int delay = m_server->m_options.latencyMs
+                        + (m_server->m_options.jitterMs > 0 ? m_random.nextInt(m_server->m_options.jitterMs + 1) : 0);
+      if (delay > 0)
+        Thread::sleep(delay);
+
+      const auto result = m_server->handle(body);
+      std::string response = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: "
+                             + std::to_string(result.size()) + "\r\n";
+      response += keepAlive ? "\r\n" : "Connection: close\r\n\r\n";
+      if (!send(response + result) || !keepAlive)
+        return jobHasFinished;
+    }
+    return jobHasFinished;
+  }
+
+ private:
+  LocalRpcServer* m_server;
+  std::unique_ptr<StreamingSocket> m_socket;
+  Random m_random;
+
+  // Waits in short steps, so stopping the server doesn't wait for idle connections.
+  bool receive(std::string* buffer) {
+    char chunk[16384];
+    while (!shouldExit()) {
+      const int ready = m_socket->waitUntilReady(true, 100);
+      if (ready < 0)
+        return false;
+      if (ready == 0)
+        continue;
+
+      const int size = m_socket->read(chunk, sizeof(chunk), false);
+      if (size <= 0)
+        return false;
+      buffer->append(chunk, static_cast<size_t>(size));
+      return true;
+    }
+    return false;
+  }
+
+  bool send(const std::string& data) {
+    return m_socket->write(data.data(), static_cast<int>(data.size())) == static_cast<int>(data.size());
+  }
+};
+
+LocalRpcServer::LocalRpcServer(const Options& options)
+    : Thread("Local RPC server")
+    , m_options(options)
+    , m_model(options.model)
+    , m_connections(MAX_CONNECTIONS)
+    , m_startTime(Time::currentTimeMillis()) {
+}
+
+LocalRpcServer::~LocalRpcServer() {
+  stop();
+}
+
+bool LocalRpcServer::start() {
+  if (!m_listener.createListener(m_options.port, "127.0.0.1"))
+    return false;
+  startThread();
+  return true;
+}
+
+void LocalRpcServer::stop() {
+  signalThreadShouldExit();
+  m_listener.close();
+  stopThread(2000);
+  m_connections.removeAllJobs(true, 2000);
+}
+
+String LocalRpcServer::getUrl() const {
+  return "http://127.0.0.1:" + String(m_options.port);
+}
+
+uint64 LocalRpcServer::getNumRequests() const {
+  return m_numRequests.load();
+}
+
+void LocalRpcServer::run() {
+  while (!threadShouldExit()) {
+    std::unique_ptr<StreamingSocket> socket(m_listener.waitForNextConnection());
+    if (socket == nullptr) {
+      if (!m_listener.isConnected())
+        break;
+      continue;
+    }
+    m_connections.addJob(new Connection(this, socket.release()), true);
+  }
+}
+
+std::string LocalRpcServer::handle(const std::string& body) {
+  const json request = json::parse(body, nullptr, false);
+  if (request.is_discarded())
+    return makeError(nullptr, -32700, "Parse error").dump();
+  if (!request.is_array())
+    return handleRequest(request).dump();
+  if (request.empty())
+    return makeError(nullptr, -32600, "Invalid request").dump();
+
+  json responses = json::array();
+  for (const auto& batchRequest : request)
+    responses.push_back(handleRequest(batchRequest));
+  return responses.dump();
+}
+
+json LocalRpcServer::handleRequest(const json& request) {
+  ++m_numRequests;
+  if (!request.is_object() || !request.count("method") || !request["method"].is_string())
+    return makeError(nullptr, -32600, "Invalid request");
+
+  const json id = request.count("id") ? request["id"] : json();
+  const auto method = request["method"].get<std::string>();
+  const json params = request.count("params") ? request["params"] : json::array();
+  const bool hasParam = params.is_array() && !params.empty();
+  json result;
+  if (method == "eth_call") {
+    if (!hasParam || !params[0].is_object())
+      return makeError(id, -32602, "Invalid params");
+    const auto s = m_model.call(fromHexData(params[0].value("data", params[0].value("input", ""))));
+    if (!s.is_ok())
+      return makeError(id, 3, s.msg);
+    result = "0x" + bin2hex(s.msg);
+  } else if (method == "eth_blockNumber") {
+    result = toQuantity(Uint256(getBlockNumber()));
+  } else if (method == "eth_getBalance") {
+    // Every account can pay for its transactions.
+    Uint256 balance(100);
+    balance.multiplyByPowerOfTen(18);
+    result = toQuantity(balance);
+  } else if (method == "eth_getTransactionCount") {
+    if (!hasParam || !params[0].is_string())
+      return makeError(id, -32602, "Invalid params");
+    ScopedLock lock(m_chainLock);
+    const auto it = m_nonces.find(fromHexData(params[0].get<std::string>()));
+    result = toQuantity(Uint256(it != m_nonces.end() ? it->second : 0));
+  } else if (method == "eth_sendRawTransaction") {
+    if (!hasParam || !params[0].is_string())
+      return makeError(id, -32602, "Invalid params");
+    std::string error;
+    const auto hash = sendRawTransaction(fromHexData(params[0].get<std::string>()), &error);
+    if (hash.empty())
+      return makeError(id, -32000, error);
+    result = "0x" + bin2hex(hash);
+  } else if (method == "eth_getTransactionReceipt") {
+    if (!hasParam || !params[0].is_string())
+      return makeError(id, -32602, "Invalid params");
+    result = getReceipt(fromHexData(params[0].get<std::string>()));
+  } else if (method == "eth_chainId") {
+    result = "0x1";
+  } else if (method == "net_version") {
+    result = "1";
+  } else if (method == "eth_gasPrice") {
+    result = "0x1388";
+  } else if (method == "eth_estimateGas") {
+    result = "0x5b8d80";
+  } else if (method == "eth_getCode") {
+    // Any address is the contract.
+    result = "0x01";
+  } else if (method == "eth_syncing") {
+    result = false;
+  } else if (method == "web3_clientVersion") {
+    result = "Playground/LocalRpcServer";
+  } else {
+    return makeError(id, -32601, "Method not found");
+  }
+  return {{"jsonrpc", "2.0"}, {"id", id}, {"result", result}};
+}
+
+uint64 LocalRpcServer::getBlockNumber() const {
+  ScopedLock lock(m_chainLock);
+  const auto elapsed = static_cast<uint64>(Time::currentTimeMillis() - m_startTime);
+  return FIRST_BLOCK + m_numTransactions + elapsed / static_cast<uint64>(m_options.blockTimeMs);
+}
+
+std::string LocalRpcServer::sendRawTransaction(const std::string& rawTransaction, std::string* error) {
+  SignedTransaction transaction;
+  if (!decodeTransaction(rawTransaction, &transaction)) {
+    *error = "invalid transaction";
+    return std::string();
+  }
+
+  // A reverted transaction is still mined, with a failed receipt.
+  ScopedLock lock(m_chainLock);
+  const auto s = m_model.transact(transaction.sender, transaction.data, transaction.value);
+  const auto hash = keccak(rawTransaction);
+  ++m_numTransactions;
+  ++m_nonces[transaction.sender];
+  m_receipts[hash] = {transaction.sender, transaction.to, getBlockNumber(), s.is_ok()};
+  return hash;
+}
+
+json LocalRpcServer::getReceipt(const std::string& hash) const {
+  ScopedLock lock(m_chainLock);
+  const auto it = m_receipts.find(hash);
+  if (it == m_receipts.end())
+    return nullptr;
+
+  const auto& receipt = it->second;
+  return {
+    {"transactionHash", "0x" + bin2hex(hash)},
+    {"transactionIndex", "0x0"},
+    {"blockHash", "0x" + Uint256(receipt.blockNumber).toHex()},
+    {"blockNumber", toQuantity(Uint256(receipt.blockNumber))},
+    {"from", "0x" + bin2hex(receipt.from)},
+    {"to", "0x" + bin2hex(receipt.to)},
+    {"cumulativeGasUsed", "0x5208"},
+    {"gasUsed", "0x5208"},
+    {"contractAddress", nullptr},
+    {"logs", json::array()},
+    {"logsBloom", "0x" + std::string(512, '0')},
+    {"status", receipt.success ? "0x1" : "0x0"}
+  };
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class LocalRpcServerTest : public UnitTest {
+ public:
+  LocalRpcServerTest() : UnitTest("LocalRpcServer") {
+  }
+
+  void runTest() override {
+    LocalRpcServer::Options options;
+    options.model.numSlots = 16;
+    options.model.numProposals = 1;
+    options.model.numOrders = 1;
+    LocalRpcServer server(options);
+
+    beginTest("Requests");
+    auto response = json::parse(server.handle(R"({"jsonrpc":"2.0","id":7,"method":"eth_blockNumber","params":[]})"));
+    expect(response["id"] == 7 && response["result"].get<std::string>().compare(0, 2, "0x") == 0);
+    response = json::parse(server.handle(R"({"jsonrpc":"2.0","id":1,"method":"eth_mining"})"));
+    expect(response["error"]["code"] == -32601);
+    expect(json::parse(server.handle("{"))["error"]["code"] == -32700);
+
+    beginTest("Batch");
+    // 0x9621ff25 is numSlots().
+    response = json::parse(server.handle(
+        R"([{"jsonrpc":"2.0","id":1,"method":"eth_call","params":[{"to":"0x01","data":"0x9621ff25"},"latest"]},)"
+        R"({"jsonrpc":"2.0","id":2,"method":"eth_getTransactionReceipt","params":["0x00"]}])"));
+    expect(response.size() == 2 && response[1]["result"].is_null());
+    expect(response[0]["result"] == "0x" + std::string(62, '0') + "10");
+    expectEquals(static_cast<int>(server.getNumRequests()), 5);
+  }
+};
+
+static LocalRpcServerTest test;
+#endif
@@ -0,0 +1,100 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <json.hpp>
+#include <atomic>
+#include <map>
+#include <string>
+
+#include "JuceHeader.h"
+#include "LocalContractModel.h"
+
+// Local stand-in for an Ethereum node, serving JSON-RPC over HTTP/1.1 from a LocalContractModel. Point the app at
+// http://127.0.0.1:<port> with any contract address to run the refresh, vote and trade paths against a contract of
+// any size without a network, e.g. to benchmark them at 65536 slots and thousands of proposals.
+//
+// Serves single and batched requests on keep-alive connections: eth_call, eth_blockNumber, eth_getBalance,
+// eth_getTransactionCount, eth_sendRawTransaction, eth_getTransactionReceipt and the usual node constants. Each
+// transaction is mined into its own block right away, and a block is added every blockTimeMs in between. Every HTTP
+// request is answered after latencyMs plus up to jitterMs, like a remote node.
+//
+// Started from the command line: Playground --rpc-standin [--port P] [--slots N] [--proposals N] [--orders N]
+//                                            [--latency ms] [--jitter ms] [--block-time ms] [--seed S]
+class LocalRpcServer : private Thread {
+ public:
+  static const char* const COMMAND_LINE_FLAG;
+
+  struct Options {
+    int port = 8545;
+    int latencyMs = 0;
+    int jitterMs = 0;
+    int blockTimeMs = 15000;
+    LocalContractModel::Options model;
+  };
+
+  static bool isRequested(const StringArray& args);
+  static Options parseCommandLine(const StringArray& args);
+
+  explicit LocalRpcServer(const Options& options);
+  ~LocalRpcServer();
+
+  // False if the port can't be listened on.
+  bool start();
+  void stop();
+
+  String getUrl() const;
+  uint64 getNumRequests() const;
+
+  // Answers a JSON-RPC request body, a single request or a batch.
+  std::string handle(const std::string& body);
+
+ private:
+  struct Receipt {
+    std::string from;
+    std::string to;
+    uint64 blockNumber;
+    bool success;
+  };
+
+  class Connection;
+
+  Options m_options;
+  LocalContractModel m_model;
+  StreamingSocket m_listener;
+  ThreadPool m_connections;
+  std::atomic<uint64> m_numRequests {0};
+
+  mutable CriticalSection m_chainLock;
+  const int64 m_startTime;
+  uint64 m_numTransactions = 0;
+  std::map<std::string, uint64> m_nonces;
+  std::map<std::string, Receipt> m_receipts;
+
+  void run() override;
+
+  nlohmann::json handleRequest(const nlohmann::json& request);
+  uint64 getBlockNumber() const;
+  // Returns the transaction hash, or an empty string and the error.
+  std::string sendRawTransaction(const std::string& rawTransaction, std::string* error);
+  nlohmann::json getReceipt(const std::string& hash) const;
+
+  JUCE_DECLARE_NON_COPYABLE(LocalRpcServer)
+};
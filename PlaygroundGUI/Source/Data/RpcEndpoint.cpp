@@ -0,0 +1,196 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <curl/curl.h>
+#include <algorithm>
+
+#include "RpcEndpoint.h"
+
+using automaton::core::common::status;
+
+static const long REQUEST_TIMEOUT_SECONDS = 60;  // NOLINT(runtime/int)
+// Fewer recent requests don't give a meaningful percentile.
+static const int MIN_LATENCY_SAMPLES = 8;
+
+static size_t appendResponse(char* data, size_t size, size_t count, void* response) {
+  static_cast<std::string*>(response)->append(data, size * count);
+  return size * count;
+}
+
+static void lockShare(CURL*, curl_lock_data data, curl_lock_access, void* locks) {
+  static_cast<CriticalSection*>(locks)[data].enter();
+}
+
+static void unlockShare(CURL*, curl_lock_data data, void* locks) {
+  static_cast<CriticalSection*>(locks)[data].exit();
+}
+
+RpcEndpoint::RpcEndpoint(const std::string& url, int maxConnections, bool http2)
+    : m_url(url)
+    , m_maxConnections(jmax(1, maxConnections))
+    , m_http2(http2) {
+  m_headers = curl_slist_append(nullptr, "Content-Type: application/json");
+
+  static_assert(static_cast<size_t>(CURL_LOCK_DATA_LAST) <= sizeof(m_shareLocks) / sizeof(m_shareLocks[0]),
+                "Not enough share locks");
+  auto share = curl_share_init();
+  if (share == nullptr)
+    return;
+
+  curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+  curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+  curl_share_setopt(share, CURLSHOPT_USERDATA, m_shareLocks);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+  curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+  m_share = share;
+}
+
+RpcEndpoint::~RpcEndpoint() {
+  const ScopedLock sl(m_handlesLock);
+  jassert(m_idleHandles.size() == m_numHandles);
+  for (auto handle : m_idleHandles)
+    curl_easy_cleanup(handle);
+
+  // Only after the handles that use it.
+  if (m_share != nullptr)
+    curl_share_cleanup(m_share);
+  curl_slist_free_all(static_cast<curl_slist*>(m_headers));
+}
+
+void* RpcEndpoint::acquireHandle(bool wait) {
+  for (;;) {
+    {
+      const ScopedLock sl(m_handlesLock);
+      if (!m_idleHandles.isEmpty())
+        return m_idleHandles.removeAndReturn(m_idleHandles.size() - 1);
+
+      if (m_numHandles < m_maxConnections) {
+        if (auto handle = curl_easy_init()) {
+          if (m_share != nullptr)
+            curl_easy_setopt(handle, CURLOPT_SHARE, m_share);
+          ++m_numHandles;
+          return handle;
+        }
+        return nullptr;
+      }
+    }
+    if (!wait)
+      return nullptr;
+    m_handleReleased.wait(100);
+  }
+}
+
+void RpcEndpoint::releaseHandle(void* handle) {
+  if (handle == nullptr)
+    return;
+
+  {
+    const ScopedLock sl(m_handlesLock);
+    m_idleHandles.add(handle);
+  }
+  m_handleReleased.signal();
+}
+
+void RpcEndpoint::prepare(void* handle, const std::string& body, std::string* response) const {
+  // Options are set again on every request, the handle only keeps its connection between requests.
+  curl_easy_setopt(handle, CURLOPT_URL, m_url.c_str());
+  curl_easy_setopt(handle, CURLOPT_HTTPHEADER, m_headers);
+  curl_easy_setopt(handle, CURLOPT_POSTFIELDS, body.c_str());
+  curl_easy_setopt(handle, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));  // NOLINT(runtime/int)
+  curl_easy_setopt(handle, CURLOPT_WRITEFUNCTION, appendResponse);
+  curl_easy_setopt(handle, CURLOPT_WRITEDATA, response);
+  curl_easy_setopt(handle, CURLOPT_TIMEOUT, REQUEST_TIMEOUT_SECONDS);
+  curl_easy_setopt(handle, CURLOPT_NOSIGNAL, 1L);
+  curl_easy_setopt(handle, CURLOPT_TCP_KEEPALIVE, 1L);
+  if (m_http2)
+    curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, static_cast<long>(CURL_HTTP_VERSION_2TLS));  // NOLINT(runtime/int)
+}
+
+status RpcEndpoint::getResult(void* handle, int curlCode) {
+  if (curlCode != CURLE_OK)
+    return status::unavailable(curl_easy_strerror(static_cast<CURLcode>(curlCode)));
+
+  long httpCode = 0;  // NOLINT(runtime/int)
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &httpCode);
+  if (httpCode != 200)
+    return status::unavailable("HTTP error " + std::to_string(httpCode));
+
+  return status::ok();
+}
+
+status RpcEndpoint::post(const std::string& body, std::string* response) {
+  auto handle = acquireHandle();
+  if (handle == nullptr)
+    return status::internal("Could not create a connection.");
+
+  prepare(handle, body, response);
+  const auto s = getResult(handle, curl_easy_perform(handle));
+  releaseHandle(handle);
+  return s;
+}
+
+void RpcEndpoint::recordResult(bool succeeded, double milliseconds) {
+  const ScopedLock sl(m_statsLock);
+  m_consecutiveFailures = succeeded ? 0 : m_consecutiveFailures + 1;
+  m_latencies[m_nextLatency] = static_cast<float>(milliseconds);
+  m_nextLatency = (m_nextLatency + 1) % LATENCY_WINDOW;
+  m_numLatencies = jmin(m_numLatencies + 1, static_cast<int>(LATENCY_WINDOW));
+}
+
+double RpcEndpoint::getLatencyPercentile(double fraction) const {
+  float latencies[LATENCY_WINDOW];
+  int size = 0;
+  {
+    const ScopedLock sl(m_statsLock);
+    if (m_numLatencies < MIN_LATENCY_SAMPLES)
+      return -1;
+    size = m_numLatencies;
+    std::copy(m_latencies, m_latencies + size, latencies);
+  }
+
+  const int index = jlimit(0, size - 1, static_cast<int>(fraction * size));
+  std::nth_element(latencies, latencies + index, latencies + size);
+  return latencies[index];
+}
+
+int RpcEndpoint::getConsecutiveFailures() const {
+  const ScopedLock sl(m_statsLock);
+  return m_consecutiveFailures;
+}
+
+void RpcEndpoint::eject(double untilMs) {
+  const ScopedLock sl(m_statsLock);
+  m_ejectedUntil = untilMs;
+  m_numLatencies = 0;
+  m_nextLatency = 0;
+  m_consecutiveFailures = 0;
+}
+
+bool RpcEndpoint::isEjected(double nowMs) const {
+  const ScopedLock sl(m_statsLock);
+  return nowMs < m_ejectedUntil;
+}
+
+double RpcEndpoint::getEjectedUntil() const {
+  const ScopedLock sl(m_statsLock);
+  return m_ejectedUntil;
+}
@@ -0,0 +1,88 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "JuceHeader.h"
+#include "automaton/core/common/status.h"
+
+// One node URL of a JsonRpcClient. Keeps a pool of curl handles that share their connection cache, DNS cache and TLS
+// sessions, so a connection opened for one request is reused by whichever handle sends the next one, and the
+// latencies of the recent requests, from which the client picks endpoints and times hedged requests.
+class RpcEndpoint {
+ public:
+  // Number of recent requests the latency percentiles are computed from.
+  static const int LATENCY_WINDOW = 64;
+
+  // http2 negotiates HTTP/2 with nodes that offer it over TLS, falling back to HTTP/1.1.
+  RpcEndpoint(const std::string& url, int maxConnections, bool http2);
+  ~RpcEndpoint();
+
+  const std::string& getUrl() const noexcept { return m_url; }
+
+  // With wait set, blocks while all connections are busy, otherwise returns nullptr. Also nullptr if no handle could
+  // be created.
+  void* acquireHandle(bool wait = true);
+  void releaseHandle(void* handle);
+
+  // Sets the options of a POST of body, the response is appended to response during the transfer.
+  void prepare(void* handle, const std::string& body, std::string* response) const;
+  // Outcome of a finished transfer of handle, curlCode is its CURLcode.
+  static automaton::core::common::status getResult(void* handle, int curlCode);
+  // Blocking POST on a pooled handle.
+  automaton::core::common::status post(const std::string& body, std::string* response);
+
+  // Latency and outcome of a request sent to this endpoint.
+  void recordResult(bool succeeded, double milliseconds);
+  // Latency below which the given fraction of the recent requests completed, negative until there are a few.
+  double getLatencyPercentile(double fraction) const;
+  int getConsecutiveFailures() const;
+
+  // Ejected endpoints aren't picked until the given time (Time::getMillisecondCounterHiRes()), then start over
+  // without recorded latencies.
+  void eject(double untilMs);
+  bool isEjected(double nowMs) const;
+  double getEjectedUntil() const;
+
+ private:
+  std::string m_url;
+  int m_maxConnections;
+  bool m_http2;
+  void* m_headers = nullptr;
+
+  CriticalSection m_handlesLock;
+  WaitableEvent m_handleReleased;
+  Array<void*> m_idleHandles;
+  int m_numHandles = 0;
+
+  // curl share handle and one lock per kind of shared data (curl_lock_data).
+  void* m_share = nullptr;
+  CriticalSection m_shareLocks[8];
+
+  CriticalSection m_statsLock;
+  float m_latencies[LATENCY_WINDOW];
+  int m_numLatencies = 0;
+  int m_nextLatency = 0;
+  int m_consecutiveFailures = 0;
+  double m_ejectedUntil = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(RpcEndpoint)
+};
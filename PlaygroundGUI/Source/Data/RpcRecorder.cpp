@@ -0,0 +1,223 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <json.hpp>
+#include <iostream>
+
+#include "RpcRecorder.h"
+
+using json = nlohmann::json;
+
+using automaton::core::common::status;
+
+const char* const RpcRecorder::RECORD_FLAG = "--rpc-record";
+const char* const RpcRecorder::REPLAY_FLAG = "--rpc-replay";
+const char* const RpcRecorder::LATENCY_SCALE_FLAG = "--replay-latency-scale";
+
+static const int LOG_VERSION = 1;
+
+RpcRecorder::RpcRecorder() {
+}
+
+RpcRecorder::~RpcRecorder() {
+  stop();
+  clearSingletonInstance();
+}
+
+bool RpcRecorder::startFromCommandLine(const StringArray& args) {
+  const int recordIndex = args.indexOf(RECORD_FLAG);
+  const int replayIndex = args.indexOf(REPLAY_FLAG);
+  const int scaleIndex = args.indexOf(LATENCY_SCALE_FLAG);
+  const auto getFile = [&](int index) {
+    return File::getCurrentWorkingDirectory().getChildFile(args[index + 1].unquoted());
+  };
+
+  auto s = status::ok();
+  if (replayIndex >= 0 && replayIndex + 1 < args.size()) {
+    const double scale = scaleIndex >= 0 ? jmax(0.0, args[scaleIndex + 1].getDoubleValue()) : 1.0;
+    s = startReplay(getFile(replayIndex), scale);
+  } else if (recordIndex >= 0 && recordIndex + 1 < args.size()) {
+    s = startRecording(getFile(recordIndex));
+  }
+
+  if (!s.is_ok())
+    std::cout << "ERROR: " << s.msg << std::endl;
+  return s.is_ok();
+}
+
+status RpcRecorder::startRecording(const File& file) {
+  stop();
+
+  file.deleteFile();
+  std::unique_ptr<FileOutputStream> stream(new FileOutputStream(file));
+  if (!stream->openedOk())
+    return status::internal("Can't write the RPC recording " + file.getFullPathName().toStdString());
+
+  ScopedLock lock(m_lock);
+  m_log.reset(new GZIPCompressorOutputStream(stream.release(), 6, true, GZIPCompressorOutputStream::windowBitsGZIP));
+  m_startTime = Time::getMillisecondCounterHiRes();
+  const auto header = json({{"version", LOG_VERSION}, {"started", Time::currentTimeMillis()}}).dump() + "\n";
+  m_log->write(header.data(), header.size());
+  m_mode = RECORDING;
+  return status::ok();
+}
+
+status RpcRecorder::startReplay(const File& file, double latencyScale) {
+  stop();
+
+  MemoryBlock data;
+  if (file.existsAsFile()) {
+    GZIPDecompressorInputStream stream(file.createInputStream(), true, GZIPDecompressorInputStream::gzipFormat);
+    stream.readIntoMemoryBlock(data);
+  }
+  if (data.getSize() == 0)
+    return status::internal("Can't read the RPC recording " + file.getFullPathName().toStdString());
+
+  std::map<std::string, ReplayedKey> replayed;
+  const std::string log(static_cast<const char*>(data.getData()), data.getSize());
+  for (size_t start = 0, end = 0; start < log.size(); start = end + 1) {
+    end = log.find('\n', start);
+    if (end == std::string::npos)
+      end = log.size();
+
+    const json j_line = json::parse(log.begin() + start, log.begin() + end, nullptr, false);
+    if (start == 0) {
+      if (!j_line.is_object() || j_line.value("version", 0) != LOG_VERSION)
+        return status::internal("Unsupported RPC recording " + file.getFullPathName().toStdString());
+      continue;
+    }
+    // A session that didn't finish leaves a truncated last line.
+    if (!j_line.is_object())
+      break;
+
+    Exchange exchange;
+    exchange.ok = j_line.value("ok", false);
+    exchange.response = j_line.value("response", "");
+    exchange.firstId = j_line.value("id", static_cast<int64>(0));
+    exchange.milliseconds = j_line.value("ms", 0.0);
+    replayed[j_line.value("key", "")].exchanges.push_back(std::move(exchange));
+  }
+
+  ScopedLock lock(m_lock);
+  m_replayed.swap(replayed);
+  m_latencyScale = latencyScale;
+  m_mode = REPLAYING;
+  return status::ok();
+}
+
+void RpcRecorder::stop() {
+  ScopedLock lock(m_lock);
+  m_mode = OFF;
+  // Destroying the stream writes the end of the gzip data.
+  m_log = nullptr;
+  m_replayed.clear();
+}
+
+void RpcRecorder::record(const std::string& key,
+                         const status& result,
+                         const std::string& response,
+                         int64 firstId,
+                         double milliseconds) {
+  const json j_exchange = {
+    {"at", Time::getMillisecondCounterHiRes() - milliseconds - m_startTime},
+    {"ms", milliseconds},
+    {"key", key},
+    {"id", firstId},
+    {"ok", result.is_ok()},
+    {"response", result.is_ok() ? response : result.msg}
+  };
+  const auto line = j_exchange.dump() + "\n";
+
+  ScopedLock lock(m_lock);
+  if (m_log == nullptr)
+    return;
+  m_log->write(line.data(), line.size());
+  ++m_numRecorded;
+}
+
+status RpcRecorder::replay(const std::string& key, std::string* response, int64* firstId) {
+  Exchange exchange;
+  {
+    ScopedLock lock(m_lock);
+    const auto it = m_replayed.find(key);
+    if (it == m_replayed.end()) {
+      ++m_numMissed;
+      return status::unavailable("Not in the RPC recording: " + key.substr(0, 256));
+    }
+
+    auto& replayedKey = it->second;
+    exchange = replayedKey.exchanges[replayedKey.next];
+    if (replayedKey.next + 1 < replayedKey.exchanges.size())
+      ++replayedKey.next;
+  }
+
+  const int delay = roundToInt(exchange.milliseconds * m_latencyScale);
+  if (delay > 0)
+    Thread::sleep(delay);
+
+  ++m_numReplayed;
+  *firstId = exchange.firstId;
+  if (!exchange.ok)
+    return status::internal(exchange.response);
+  *response = exchange.response;
+  return status::ok();
+}
+
+JUCE_IMPLEMENT_SINGLETON(RpcRecorder)
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class RpcRecorderTest : public UnitTest {
+ public:
+  RpcRecorderTest() : UnitTest("RpcRecorder") {
+  }
+
+  void runTest() override {
+    TemporaryFile log(".log.gz");
+    RpcRecorder recorder;
+
+    beginTest("Record");
+    expect(recorder.startRecording(log.getFile()).is_ok());
+    expect(recorder.isRecording());
+    recorder.record("eth_blockNumber []\n", status::ok(), "{\"result\":\"0x1\"}", 7, 12.5);
+    recorder.record("eth_blockNumber []\n", status::ok(), "{\"result\":\"0x2\"}", 9, 3);
+    recorder.record("contract castVote [100,1,1]", status::internal("reverted"), "", 0, 40);
+    recorder.stop();
+    expectEquals(static_cast<int>(recorder.getNumRecorded()), 3);
+
+    beginTest("Replay");
+    expect(recorder.startReplay(log.getFile(), 0).is_ok());
+    std::string response;
+    int64 firstId = 0;
+    expect(recorder.replay("eth_blockNumber []\n", &response, &firstId).is_ok());
+    expect(response == "{\"result\":\"0x1\"}" && firstId == 7);
+    expect(recorder.replay("eth_blockNumber []\n", &response, &firstId).is_ok());
+    expect(response == "{\"result\":\"0x2\"}" && firstId == 9);
+    // The last exchange of a key repeats.
+    expect(recorder.replay("eth_blockNumber []\n", &response, &firstId).is_ok());
+    expect(response == "{\"result\":\"0x2\"}");
+
+    const auto s = recorder.replay("contract castVote [100,1,1]", &response, &firstId);
+    expect(!s.is_ok() && s.msg == "reverted");
+    expect(!recorder.replay("eth_chainId []\n", &response, &firstId).is_ok());
+    expectEquals(static_cast<int>(recorder.getNumMissed()), 1);
+  }
+};
+
+static RpcRecorderTest test;
+#endif
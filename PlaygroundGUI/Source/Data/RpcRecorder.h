@@ -0,0 +1,114 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JuceHeader.h"
+#include "automaton/core/common/status.h"
+
+// Records the RPC traffic of a session and serves it back later, so slow refreshes can be reproduced and the timing
+// of e.g. readContract or fetchProposals compared between builds on exactly the same data.
+//
+// Exchanges are keyed by what was asked, without JSON-RPC ids: the (method, params) list of a JsonRpcClient request
+// or batch, or the function and params of a contract call that went through eth_contract (transactions). The log is
+// gzipped JSON, one exchange per line with its response and how long it took.
+//
+// When replaying, the recorded exchanges of a key are served in their recorded order, the last one again once they
+// are used up, after the recorded time multiplied by the latency scale (0 answers at once). Nothing is sent to the
+// network, unknown keys fail.
+//
+// Started from the command line: Playground --rpc-record file.log.gz
+//                                Playground --rpc-replay file.log.gz [--replay-latency-scale x]
+class RpcRecorder : public DeletedAtShutdown {
+ public:
+  static const char* const RECORD_FLAG;
+  static const char* const REPLAY_FLAG;
+  static const char* const LATENCY_SCALE_FLAG;
+
+  RpcRecorder();
+  ~RpcRecorder();
+
+  // Starts recording or replaying if the command line asks for it. False if the log can't be opened.
+  bool startFromCommandLine(const StringArray& args);
+
+  automaton::core::common::status startRecording(const File& file);
+  automaton::core::common::status startReplay(const File& file, double latencyScale = 1.0);
+  // Finishes the log when recording.
+  void stop();
+
+  bool isRecording() const noexcept { return m_mode.load(std::memory_order_relaxed) == RECORDING; }
+  bool isReplaying() const noexcept { return m_mode.load(std::memory_order_relaxed) == REPLAYING; }
+  // Recording or replaying. The on-disk contract cache and the call cache are bypassed then, they would change which
+  // requests are sent, so a replay asks for exactly what was recorded.
+  bool isActive() const noexcept { return m_mode.load(std::memory_order_relaxed) != OFF; }
+
+  // firstId is the JSON-RPC id of the (first) request, the replayed response refers to the recorded one.
+  void record(const std::string& key,
+              const automaton::core::common::status& result,
+              const std::string& response,
+              int64 firstId,
+              double milliseconds);
+  automaton::core::common::status replay(const std::string& key, std::string* response, int64* firstId);
+
+  uint64 getNumRecorded() const noexcept { return m_numRecorded.load(); }
+  uint64 getNumReplayed() const noexcept { return m_numReplayed.load(); }
+  uint64 getNumMissed() const noexcept { return m_numMissed.load(); }
+
+  JUCE_DECLARE_SINGLETON(RpcRecorder, false)
+
+ private:
+  enum Mode {
+    OFF,
+    RECORDING,
+    REPLAYING
+  };
+
+  struct Exchange {
+    bool ok;
+    std::string response;
+    int64 firstId;
+    double milliseconds;
+  };
+
+  struct ReplayedKey {
+    std::vector<Exchange> exchanges;
+    size_t next = 0;
+  };
+
+  std::atomic<int> m_mode {OFF};
+  CriticalSection m_lock;
+
+  std::unique_ptr<OutputStream> m_log;
+  double m_startTime = 0;
+
+  std::map<std::string, ReplayedKey> m_replayed;
+  double m_latencyScale = 1.0;
+
+  std::atomic<uint64> m_numRecorded {0};
+  std::atomic<uint64> m_numReplayed {0};
+  std::atomic<uint64> m_numMissed {0};
+
+  JUCE_DECLARE_NON_COPYABLE(RpcRecorder)
+};
@@ -0,0 +1,179 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <json.hpp>
+#include <cmath>
+
+#include "RpcStats.h"
+
+using json = nlohmann::json;
+
+// Bucket i holds latencies from MIN_MS * 2^(i / BUCKETS_PER_OCTAVE) up to the next bucket, the last one everything
+// from about 100 s.
+static const double MIN_MS = 0.1;
+static const int BUCKETS_PER_OCTAVE = 8;
+static const int NUM_BUCKETS = 20 * BUCKETS_PER_OCTAVE;
+
+static int getBucket(double milliseconds) {
+  if (milliseconds <= MIN_MS)
+    return 0;
+  const int bucket = static_cast<int>(std::floor(BUCKETS_PER_OCTAVE * std::log2(milliseconds / MIN_MS)));
+  return jlimit(0, NUM_BUCKETS - 1, bucket);
+}
+
+// Geometric middle of a bucket, at most 5% off any latency in it.
+static double getBucketMiddle(int bucket) {
+  return MIN_MS * std::pow(2.0, (bucket + 0.5) / BUCKETS_PER_OCTAVE);
+}
+
+RpcStats::RpcStats() {
+}
+
+RpcStats::~RpcStats() {
+  clearSingletonInstance();
+}
+
+void RpcStats::record(const std::string& method,
+                      bool succeeded,
+                      double milliseconds,
+                      size_t bytesSent,
+                      size_t bytesReceived) {
+  const int bucket = getBucket(milliseconds);
+  const ScopedLock sl(m_lock);
+  auto& entry = m_entries[method];
+  if (entry.histogram.empty())
+    entry.histogram.resize(NUM_BUCKETS, 0);
+  ++entry.histogram[static_cast<size_t>(bucket)];
+
+  auto& stats = entry.stats;
+  ++stats.calls;
+  if (!succeeded)
+    ++stats.errors;
+  stats.bytesSent += bytesSent;
+  stats.bytesReceived += bytesReceived;
+  stats.maxBytesReceived = jmax(stats.maxBytesReceived, static_cast<uint64>(bytesReceived));
+  stats.totalMs += milliseconds;
+  stats.maxMs = jmax(stats.maxMs, milliseconds);
+}
+
+void RpcStats::recordCacheHit(const std::string& method) {
+  const ScopedLock sl(m_lock);
+  ++m_entries[method].stats.cacheHits;
+}
+
+double RpcStats::getPercentile(const Entry& entry, double fraction) {
+  const auto calls = entry.stats.calls;
+  if (calls == 0)
+    return 0;
+
+  const uint64 rank = jmax<uint64>(1, static_cast<uint64>(std::ceil(fraction * calls)));
+  uint64 count = 0;
+  for (size_t bucket = 0; bucket < entry.histogram.size(); ++bucket) {
+    count += entry.histogram[bucket];
+    if (count >= rank)
+      return jmin(getBucketMiddle(static_cast<int>(bucket)), entry.stats.maxMs);
+  }
+  return entry.stats.maxMs;
+}
+
+std::vector<RpcStats::MethodStats> RpcStats::getStats() const {
+  const ScopedLock sl(m_lock);
+  std::vector<MethodStats> result;
+  result.reserve(m_entries.size());
+  for (const auto& item : m_entries) {
+    result.push_back(item.second.stats);
+    auto& stats = result.back();
+    stats.method = item.first;
+    stats.p50Ms = getPercentile(item.second, 0.50);
+    stats.p95Ms = getPercentile(item.second, 0.95);
+    stats.p99Ms = getPercentile(item.second, 0.99);
+  }
+  return result;
+}
+
+std::string RpcStats::toJson() const {
+  json j_stats = json::array();
+  for (const auto& stats : getStats()) {
+    j_stats.push_back({
+      {"method", stats.method},
+      {"calls", stats.calls},
+      {"errors", stats.errors},
+      {"cache_hits", stats.cacheHits},
+      {"bytes_sent", stats.bytesSent},
+      {"bytes_received", stats.bytesReceived},
+      {"max_bytes_received", stats.maxBytesReceived},
+      {"mean_ms", stats.calls > 0 ? stats.totalMs / stats.calls : 0.0},
+      {"max_ms", stats.maxMs},
+      {"p50_ms", stats.p50Ms},
+      {"p95_ms", stats.p95Ms},
+      {"p99_ms", stats.p99Ms}
+    });
+  }
+  return j_stats.dump(2);
+}
+
+void RpcStats::reset() {
+  const ScopedLock sl(m_lock);
+  m_entries.clear();
+}
+
+JUCE_IMPLEMENT_SINGLETON(RpcStats)
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class RpcStatsTest : public UnitTest {
+ public:
+  RpcStatsTest() : UnitTest("RpcStats") {
+  }
+
+  void runTest() override {
+    RpcStats stats;
+
+    beginTest("Percentiles");
+    for (int i = 1; i <= 100; ++i)
+      stats.record("getVote", i != 100, i, 36, 32);
+    stats.recordCacheHit("getVote");
+    stats.record("eth_blockNumber", true, 5, 60, 40);
+
+    const auto result = stats.getStats();
+    expectEquals(static_cast<int>(result.size()), 2);
+    const auto& vote = result[1];
+    expect(vote.method == "getVote");
+    expectEquals(static_cast<int>(vote.calls), 100);
+    expectEquals(static_cast<int>(vote.errors), 1);
+    expectEquals(static_cast<int>(vote.cacheHits), 1);
+    expectEquals(static_cast<int>(vote.bytesReceived), 3200);
+    expectWithinAbsoluteError(vote.p50Ms, 50.0, 50 * 0.05);
+    expectWithinAbsoluteError(vote.p95Ms, 95.0, 95 * 0.05);
+    expectWithinAbsoluteError(vote.p99Ms, 99.0, 99 * 0.05);
+    expectEquals(vote.maxMs, 100.0);
+    expectEquals(result[0].p99Ms, 5.0);
+
+    beginTest("JSON");
+    const auto j_stats = json::parse(stats.toJson());
+    expectEquals(static_cast<int>(j_stats.size()), 2);
+    expect(j_stats[1]["method"] == "getVote");
+    expect(j_stats[1]["errors"] == 1);
+
+    stats.reset();
+    expect(stats.getStats().empty());
+  }
+};
+
+static RpcStatsTest test;
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "JuceHeader.h"
+
+// Per method counters of the RPC traffic: calls, errors, bytes and latency percentiles, shown on the Debug page.
+//
+// Methods are JSON-RPC methods recorded by JsonRpcClient (eth_call, eth_blockNumber, ..., and "eth_call batch" for a
+// whole batch) and contract functions recorded where they are called (getOwners, getVote, getOrder, ...). A contract
+// function in a batch is charged the time of the whole batch, that's how long its caller waited. Calls answered by
+// the call cache only count as cache hits.
+//
+// Latencies go into a histogram with buckets 9% apart, so the percentiles cover the whole session in fixed memory.
+class RpcStats : public DeletedAtShutdown {
+ public:
+  struct MethodStats {
+    std::string method;
+    uint64 calls = 0;
+    uint64 errors = 0;
+    uint64 cacheHits = 0;
+    uint64 bytesSent = 0;
+    uint64 bytesReceived = 0;
+    uint64 maxBytesReceived = 0;
+    double totalMs = 0;
+    double maxMs = 0;
+    double p50Ms = 0;
+    double p95Ms = 0;
+    double p99Ms = 0;
+  };
+
+  RpcStats();
+  ~RpcStats();
+
+  void record(const std::string& method, bool succeeded, double milliseconds, size_t bytesSent, size_t bytesReceived);
+  void recordCacheHit(const std::string& method);
+
+  // Sorted by method.
+  std::vector<MethodStats> getStats() const;
+  // getStats() as a JSON array, latencies in milliseconds.
+  std::string toJson() const;
+  void reset();
+
+  JUCE_DECLARE_SINGLETON(RpcStats, false)
+
+ private:
+  struct Entry {
+    MethodStats stats;
+    std::vector<uint32> histogram;
+  };
+
+  mutable CriticalSection m_lock;
+  std::map<std::string, Entry> m_entries;
+
+  static double getPercentile(const Entry& entry, double fraction);
+
+  JUCE_DECLARE_NON_COPYABLE(RpcStats)
+};
@@ -0,0 +1,237 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+
+#include "SlotPagesFetcher.h"
+#include "RpcStats.h"
+#include "automaton/core/crypto/cryptopp/Keccak_256_cryptopp.h"
+
+using automaton::core::common::status;
+using automaton::core::crypto::cryptopp::Keccak_256_cryptopp;
+
+static const size_t WORD_SIZE = 32;
+
+static std::string encodeUint(uint64 value) {
+  std::string word(WORD_SIZE, '\0');
+  for (size_t i = 0; i < 8; ++i)
+    word[WORD_SIZE - 1 - i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  return word;
+}
+
+static int hexDigit(char c) noexcept {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static bool decodeHexWord(const char* hex, unsigned char* word) noexcept {
+  for (size_t i = 0; i < WORD_SIZE; ++i) {
+    const int high = hexDigit(hex[2 * i]);
+    const int low = hexDigit(hex[2 * i + 1]);
+    if (high < 0 || low < 0)
+      return false;
+    word[i] = static_cast<unsigned char>((high << 4) | low);
+  }
+  return true;
+}
+
+static uint64 decodeUint64(const unsigned char* word) noexcept {
+  uint64 value = 0;
+  for (size_t i = WORD_SIZE - 8; i < WORD_SIZE; ++i)
+    value = (value << 8) | word[i];
+  return value;
+}
+
+// Call data of f(uint256 start, uint256 len).
+static std::string encodeRangeCall(const std::string& signature, uint32_t start, uint32_t len) {
+  Keccak_256_cryptopp hasher;
+  uint8_t digest[32];
+  hasher.calculate_digest(reinterpret_cast<const uint8_t*>(signature.data()), signature.size(), digest);
+  return std::string(reinterpret_cast<const char*>(digest), 4) + encodeUint(start) + encodeUint(len);
+}
+
+// Decodes a single returned dynamic array straight from the hex digits of the result, handing each of its first
+// maxWords words to onWord(i, word). Words are decoded into a stack buffer, nothing is allocated.
+template <typename WordHandler>
+static status decodeHexWordArray(const char* hex, size_t numDigits, uint32_t maxWords, WordHandler onWord) {
+  const size_t size = numDigits / 2;
+  unsigned char word[WORD_SIZE];
+  if (size < 2 * WORD_SIZE || !decodeHexWord(hex, word))
+    return status::internal("Invalid slots array");
+
+  const uint64 offset = decodeUint64(word);
+  if (offset > size - WORD_SIZE || !decodeHexWord(hex + 2 * offset, word))
+    return status::internal("Invalid slots array");
+
+  const uint64 length = decodeUint64(word);
+  if (length > (size - offset - WORD_SIZE) / WORD_SIZE)
+    return status::internal("Invalid slots array");
+
+  for (uint32_t i = 0; i < length && i < maxWords; ++i) {
+    if (!decodeHexWord(hex + 2 * (offset + WORD_SIZE * (i + 1)), word))
+      return status::internal("Invalid slots array");
+    onWord(i, word);
+  }
+  return status::ok();
+}
+
+SlotPagesFetcher::SlotPagesFetcher(std::shared_ptr<JsonRpcClient> client,
+                                   const std::string& contractAddress,
+                                   std::shared_ptr<AdaptivePager> pager,
+                                   int pagesInFlight)
+    : m_client(client)
+    , m_contractAddress(contractAddress)
+    , m_pager(pager)
+    , m_pagesInFlight(jmax(1, pagesInFlight)) {
+}
+
+// Owners, difficulties and claim times are read in a single batch. The response is scanned in place and the hex
+// words are decoded straight into the slot arrays.
+status SlotPagesFetcher::fetchPage(uint32_t start, uint32_t len, ValidatorSlots* slots, size_t* responseBytes) {
+  static const char* const functions[] = {"getOwners", "getDifficulties", "getLastClaimTimes"};
+  const std::vector<std::string> calls = {
+    encodeRangeCall("getOwners(uint256,uint256)", start, len),
+    encodeRangeCall("getDifficulties(uint256,uint256)", start, len),
+    encodeRangeCall("getLastClaimTimes(uint256,uint256)", start, len)
+  };
+
+  size_t resultSizes[3] = {0, 0, 0};
+  const auto onResult = [=, &resultSizes](size_t call, const char* hex, size_t numDigits) {
+    resultSizes[call] = numDigits / 2;
+    switch (call) {
+      case 0:
+        return decodeHexWordArray(hex, numDigits, len, [=](uint32_t i, const unsigned char* word) {
+          slots->setOwner(start + i, word + WORD_SIZE - ValidatorSlots::OWNER_SIZE);
+        });
+      case 1:
+        return decodeHexWordArray(hex, numDigits, len, [=](uint32_t i, const unsigned char* word) {
+          slots->setDifficulty(start + i, word);
+        });
+      default:
+        return decodeHexWordArray(hex, numDigits, len, [=](uint32_t i, const unsigned char* word) {
+          slots->setClaimTime(start + i, decodeUint64(word));
+        });
+    }
+  };
+
+  const double startTime = Time::getMillisecondCounterHiRes();
+  const auto s = m_client->ethCallBatchStream(m_contractAddress, calls, onResult);
+  const double milliseconds = Time::getMillisecondCounterHiRes() - startTime;
+  *responseBytes = 0;
+  for (size_t call = 0; call < calls.size(); ++call) {
+    RpcStats::getInstance()->record(functions[call], s.is_ok(), milliseconds, calls[call].size(), resultSizes[call]);
+    *responseBytes += resultSizes[call];
+  }
+  return s;
+}
+
+status SlotPagesFetcher::fetchRange(uint32_t start,
+                                    uint32_t end,
+                                    ValidatorSlots* slots,
+                                    const std::atomic<bool>& aborted,
+                                    std::atomic<uint32_t>* completed) {
+  while (start < end && !aborted) {
+    const uint32_t len = jmin(m_pager->getPageSize(), end - start);
+    size_t responseBytes = 0;
+    const double startTime = Time::getMillisecondCounterHiRes();
+    const auto s = fetchPage(start, len, slots, &responseBytes);
+    if (!s.is_ok()) {
+      if (m_pager->recordFailure(len, s))
+        continue;
+      return s;
+    }
+
+    m_pager->recordSuccess(len, Time::getMillisecondCounterHiRes() - startTime, responseBytes);
+    start += len;
+    *completed += len;
+  }
+  return status::ok();
+}
+
+status SlotPagesFetcher::fetch(AsyncTask* task, ValidatorSlots* slots) {
+  const uint32_t slotsNumber = static_cast<uint32_t>(slots->size());
+
+  std::atomic<uint32_t> completedSlots {0};
+  std::atomic<int> runningWorkers {m_pagesInFlight};
+  std::atomic<bool> aborted {false};
+  WaitableEvent pageCompleted;
+  CriticalSection lock;
+  uint32_t nextSlot = 0;
+  status error = status::ok();
+
+  // Every worker keeps taking the next range at the current page size until all slots were taken.
+  ThreadPool pool(m_pagesInFlight);
+  for (int worker = 0; worker < m_pagesInFlight; ++worker) {
+    pool.addJob([&]() {
+      while (!aborted) {
+        uint32_t start = 0;
+        uint32_t end = 0;
+        {
+          const ScopedLock sl(lock);
+          start = nextSlot;
+          end = nextSlot = jmin(slotsNumber, nextSlot + m_pager->getPageSize());
+        }
+        if (start == end)
+          break;
+
+        auto s = fetchRange(start, end, slots, aborted, &completedSlots);
+        if (!s.is_ok()) {
+          const ScopedLock sl(lock);
+          if (error.is_ok())
+            error = s;
+          aborted = true;
+        }
+        pageCompleted.signal();
+      }
+      --runningWorkers;
+      pageCompleted.signal();
+      return ThreadPoolJob::jobHasFinished;
+    });
+  }
+
+  uint32_t reportedSlots = 0;
+  while (runningWorkers > 0 && !aborted) {
+    if (task->threadShouldExit()) {
+      aborted = true;
+      break;
+    }
+    const uint32_t completed = completedSlots;
+    if (completed != reportedSlots) {
+      reportedSlots = completed;
+      task->setProgress((1.0 * completed) / slotsNumber);
+      task->setStatusMessage("Getting slots " + String(completed) + " of " + String(slotsNumber)
+                             + ", " + String(m_pager->getPageSize()) + " per page");
+    }
+    pageCompleted.wait(100);
+  }
+
+  // Running pages finish their current call.
+  pool.removeAllJobs(true, -1);
+
+  if (task->threadShouldExit())
+    return status::internal("Aborted");
+
+  const ScopedLock sl(lock);
+  return error;
+}
@@ -0,0 +1,68 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "JuceHeader.h"
+#include "AdaptivePager.h"
+#include "JsonRpcClient.h"
+#include "ValidatorSlots.h"
+#include "Utils/AsyncTask.h"
+
+// Reads all validator slots with several pages in flight at once. A page is a single batch of getOwners,
+// getDifficulties and getLastClaimTimes on a pooled connection of the client, its responses are decoded on the worker
+// thread and written straight into its own range of the result, so pages can complete in any order. Each page is as
+// large as the pager says at the time it is sent, a page that failed because it was too large is read again smaller.
+class SlotPagesFetcher {
+ public:
+  static const int DEFAULT_PAGES_IN_FLIGHT = 4;
+
+  // Pages beyond the connections of the client wait for one to be released.
+  SlotPagesFetcher(std::shared_ptr<JsonRpcClient> client,
+                   const std::string& contractAddress,
+                   std::shared_ptr<AdaptivePager> pager,
+                   int pagesInFlight);
+
+  // Blocks until all pages were read, a page failed or the task was asked to exit. Progress goes to the task.
+  automaton::core::common::status fetch(AsyncTask* task, ValidatorSlots* slots);
+
+ private:
+  std::shared_ptr<JsonRpcClient> m_client;
+  std::string m_contractAddress;
+  std::shared_ptr<AdaptivePager> m_pager;
+  int m_pagesInFlight;
+
+  automaton::core::common::status fetchPage(uint32_t start,
+                                            uint32_t len,
+                                            ValidatorSlots* slots,
+                                            size_t* responseBytes);
+  // Reads the slots from start to end page by page, adding the slots read to completed.
+  automaton::core::common::status fetchRange(uint32_t start,
+                                             uint32_t end,
+                                             ValidatorSlots* slots,
+                                             const std::atomic<bool>& aborted,
+                                             std::atomic<uint32_t>* completed);
+
+  JUCE_DECLARE_NON_COPYABLE(SlotPagesFetcher)
+};
@@ -0,0 +1,110 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "ValidatorSlots.h"
+#include "automaton/core/io/io.h"
+
+using automaton::core::io::bin2hex;
+using automaton::core::io::hex2bin;
+
+const size_t ValidatorSlots::DIFFICULTY_SIZE;
+const size_t ValidatorSlots::OWNER_SIZE;
+
+void ValidatorSlots::resize(size_t size) {
+  m_difficulties.resize(size * DIFFICULTY_SIZE, 0);
+  m_owners.resize(size * OWNER_SIZE, 0);
+  m_claimTimes.resize(size, 0);
+}
+
+std::string ValidatorSlots::getDifficultyBytes(size_t slot) const {
+  return std::string(reinterpret_cast<const char*>(getDifficulty(slot)), DIFFICULTY_SIZE);
+}
+
+std::string ValidatorSlots::getOwnerHex(size_t slot) const {
+  return bin2hex(std::string(reinterpret_cast<const char*>(getOwner(slot)), OWNER_SIZE));
+}
+
+bool ValidatorSlots::isOwnedBy(size_t slot, const unsigned char* owner) const noexcept {
+  return memcmp(getOwner(slot), owner, OWNER_SIZE) == 0;
+}
+
+bool ValidatorSlots::isSameSlot(size_t slot, const ValidatorSlots& other) const noexcept {
+  return getClaimTime(slot) == other.getClaimTime(slot)
+      && memcmp(getDifficulty(slot), other.getDifficulty(slot), DIFFICULTY_SIZE) == 0
+      && memcmp(getOwner(slot), other.getOwner(slot), OWNER_SIZE) == 0;
+}
+
+size_t ValidatorSlots::countOwnedBy(const unsigned char* owner) const noexcept {
+  size_t count = 0;
+  for (size_t slot = 0; slot < size(); ++slot) {
+    if (isOwnedBy(slot, owner))
+      ++count;
+  }
+  return count;
+}
+
+void ValidatorSlots::setDifficulty(size_t slot, const unsigned char* difficulty) noexcept {
+  memcpy(&m_difficulties[slot * DIFFICULTY_SIZE], difficulty, DIFFICULTY_SIZE);
+}
+
+void ValidatorSlots::setOwner(size_t slot, const unsigned char* owner) noexcept {
+  memcpy(&m_owners[slot * OWNER_SIZE], owner, OWNER_SIZE);
+}
+
+void ValidatorSlots::setDifficulties(const unsigned char* difficulties) noexcept {
+  if (!m_difficulties.empty())
+    memcpy(m_difficulties.data(), difficulties, m_difficulties.size());
+}
+
+void ValidatorSlots::setOwners(const unsigned char* owners) noexcept {
+  if (!m_owners.empty())
+    memcpy(m_owners.data(), owners, m_owners.size());
+}
+
+void ValidatorSlots::set(size_t slot, const ValidatorSlot& validatorSlot) {
+  // Shorter difficulties have leading zero bytes.
+  unsigned char difficulty[DIFFICULTY_SIZE] = {0};
+  const size_t size = std::min(validatorSlot.difficulty.size(), DIFFICULTY_SIZE);
+  memcpy(difficulty + DIFFICULTY_SIZE - size,
+         validatorSlot.difficulty.data() + validatorSlot.difficulty.size() - size, size);
+  setDifficulty(slot, difficulty);
+
+  unsigned char owner[OWNER_SIZE] = {0};
+  parseOwner(validatorSlot.owner, owner);
+  setOwner(slot, owner);
+
+  setClaimTime(slot, std::strtoull(validatorSlot.last_claim_time.c_str(), nullptr, 10));
+}
+
+bool ValidatorSlots::parseOwner(const std::string& address, unsigned char* owner) {
+  const size_t start = address.compare(0, 2, "0x") == 0 ? 2 : 0;
+  if (address.size() - start != 2 * OWNER_SIZE)
+    return false;
+
+  const auto bytes = hex2bin(address.substr(start));
+  if (bytes.size() != OWNER_SIZE)
+    return false;
+
+  memcpy(owner, bytes.data(), OWNER_SIZE);
+  return true;
+}
@@ -0,0 +1,79 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A slot as returned by the contract calls: 32 byte binary difficulty, hex owner without 0x and decimal claim time.
+// Only used to pass single slots around, all slots are kept in ValidatorSlots.
+struct ValidatorSlot {
+  std::string difficulty;
+  std::string owner;
+  std::string last_claim_time;
+};
+
+// All validator slots of a contract as parallel fixed width arrays: 32 byte big-endian difficulties, 20 byte owner
+// addresses and claim times. Readers get views into the arrays, which stay valid until the slots are resized.
+class ValidatorSlots {
+ public:
+  static const size_t DIFFICULTY_SIZE = 32;
+  static const size_t OWNER_SIZE = 20;
+
+  size_t size() const noexcept { return m_claimTimes.size(); }
+  bool empty() const noexcept { return m_claimTimes.empty(); }
+
+  // New slots have no owner and zero difficulty.
+  void resize(size_t size);
+
+  const unsigned char* getDifficulty(size_t slot) const noexcept { return &m_difficulties[slot * DIFFICULTY_SIZE]; }
+  const unsigned char* getOwner(size_t slot) const noexcept { return &m_owners[slot * OWNER_SIZE]; }
+  uint64_t getClaimTime(size_t slot) const noexcept { return m_claimTimes[slot]; }
+
+  // Whole arrays, size() * DIFFICULTY_SIZE and size() * OWNER_SIZE bytes, e.g. to store all slots at once.
+  const unsigned char* getDifficulties() const noexcept { return m_difficulties.data(); }
+  const unsigned char* getOwners() const noexcept { return m_owners.data(); }
+
+  // Copies in the formats of ValidatorSlot.
+  std::string getDifficultyBytes(size_t slot) const;
+  std::string getOwnerHex(size_t slot) const;
+
+  bool isOwnedBy(size_t slot, const unsigned char* owner) const noexcept;
+  // Same difficulty, owner and claim time as the slot of other.
+  bool isSameSlot(size_t slot, const ValidatorSlots& other) const noexcept;
+  size_t countOwnedBy(const unsigned char* owner) const noexcept;
+
+  void setDifficulty(size_t slot, const unsigned char* difficulty) noexcept;
+  void setOwner(size_t slot, const unsigned char* owner) noexcept;
+  void setClaimTime(size_t slot, uint64_t claimTime) noexcept { m_claimTimes[slot] = claimTime; }
+  void set(size_t slot, const ValidatorSlot& validatorSlot);
+  // Copy size() slots at once, in the formats of getDifficulties() and getOwners().
+  void setDifficulties(const unsigned char* difficulties) noexcept;
+  void setOwners(const unsigned char* owners) noexcept;
+
+  // Parses a hex address with or without 0x. Returns false and leaves owner unchanged if it isn't 20 bytes.
+  static bool parseOwner(const std::string& address, unsigned char* owner);
+
+ private:
+  std::vector<unsigned char> m_difficulties;
+  std::vector<unsigned char> m_owners;
+  std::vector<uint64_t> m_claimTimes;
+};
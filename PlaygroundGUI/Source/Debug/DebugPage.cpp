@@ -18,6 +18,7 @@
  */
 
 #include "DebugPage.h"
+#include "Data/RpcStats.h"
 
 class TaskLogComponent : public Component
                        , public Button::Listener {
@@ -75,6 +76,156 @@ class TaskLogComponent : public Component
   Label m_title;
 };
 
+// Live per method RPC stats, refreshed every second while shown.
+class RpcStatsComponent : public Component
+                        , public TableListBoxModel
+                        , public Button::Listener
+                        , private Timer {
+ public:
+  enum Columns {
+    Method = 1
+    , Calls
+    , Errors
+    , CacheHits
+    , P50
+    , P95
+    , P99
+    , Max
+    , Sent
+    , Received
+    , MaxReceived
+  };
+
+  RpcStatsComponent(): m_exportBtn("Export JSON"), m_resetBtn("Reset") {
+    m_title.setText("RPC", NotificationType::dontSendNotification);
+    m_title.setFont(Font(15.f, Font::bold));
+    addAndMakeVisible(m_title);
+
+    m_exportBtn.addListener(this);
+    addAndMakeVisible(m_exportBtn);
+    m_resetBtn.addListener(this);
+    addAndMakeVisible(m_resetBtn);
+
+    m_table.setModel(this);
+    auto& header = m_table.getHeader();
+    header.setStretchToFitActive(true);
+    header.addColumn(translate("Method"), Method, 160);
+    header.addColumn(translate("Calls"), Calls, 60);
+    header.addColumn(translate("Errors"), Errors, 80);
+    header.addColumn(translate("Cache hits"), CacheHits, 70);
+    header.addColumn(translate("p50 ms"), P50, 60);
+    header.addColumn(translate("p95 ms"), P95, 60);
+    header.addColumn(translate("p99 ms"), P99, 60);
+    header.addColumn(translate("Max ms"), Max, 60);
+    header.addColumn(translate("Sent"), Sent, 70);
+    header.addColumn(translate("Received"), Received, 70);
+    header.addColumn(translate("Max response"), MaxReceived, 80);
+    addAndMakeVisible(m_table);
+
+    startTimer(1000);
+  }
+
+  void resized() override {
+    auto bounds = getLocalBounds();
+    auto titleBounds = bounds.removeFromTop(30);
+    m_resetBtn.setBounds(titleBounds.removeFromRight(100).reduced(2));
+    m_exportBtn.setBounds(titleBounds.removeFromRight(100).reduced(2));
+    m_title.setBounds(titleBounds);
+    m_table.setBounds(bounds);
+  }
+
+  void buttonClicked(Button* button) override {
+    if (button == &m_exportBtn) {
+      FileChooser chooser("Export RPC stats",
+                          File::getSpecialLocation(File::userDocumentsDirectory).getChildFile("rpc_stats.json"),
+                          "*.json");
+      if (chooser.browseForFileToSave(true))
+        chooser.getResult().replaceWithText(RpcStats::getInstance()->toJson());
+    } else if (button == &m_resetBtn) {
+      RpcStats::getInstance()->reset();
+      refresh();
+    }
+  }
+
+  int getNumRows() override {
+    return static_cast<int>(m_stats.size());
+  }
+
+  void paintRowBackground(Graphics& g, int rowNumber, int width, int height, bool rowIsSelected) override {
+    auto colour = LookAndFeel::getDefaultLookAndFeel().findColour(TableListBox::backgroundColourId);
+    g.setColour(rowIsSelected ? colour.darker(0.3f) : colour);
+    g.fillRect(0, 0, width, height);
+  }
+
+  void paintCell(Graphics& g, int rowNumber, int columnId, int width, int height, bool rowIsSelected) override {
+    if (rowNumber < 0 || rowNumber >= getNumRows())
+      return;
+
+    const auto& stats = m_stats[static_cast<size_t>(rowNumber)];
+    String text;
+    switch (columnId) {
+      case Method:
+        text = stats.method;
+        break;
+      case Calls:
+        text = String(stats.calls);
+        break;
+      case Errors:
+        text = String(stats.errors);
+        if (stats.calls > 0)
+          text << " (" << String(100.0 * stats.errors / stats.calls, 1) << "%)";
+        break;
+      case CacheHits:
+        text = String(stats.cacheHits);
+        break;
+      case P50:
+        text = String(stats.p50Ms, 1);
+        break;
+      case P95:
+        text = String(stats.p95Ms, 1);
+        break;
+      case P99:
+        text = String(stats.p99Ms, 1);
+        break;
+      case Max:
+        text = String(stats.maxMs, 1);
+        break;
+      case Sent:
+        text = File::descriptionOfSizeInBytes(static_cast<int64>(stats.bytesSent));
+        break;
+      case Received:
+        text = File::descriptionOfSizeInBytes(static_cast<int64>(stats.bytesReceived));
+        break;
+      case MaxReceived:
+        text = File::descriptionOfSizeInBytes(static_cast<int64>(stats.maxBytesReceived));
+        break;
+      default:
+        break;
+    }
+
+    g.setColour(stats.errors > 0 && columnId == Errors ? Colours::orange : Colours::white);
+    g.drawText(text, 2, 0, width - 4, height, Justification::centredLeft);
+  }
+
+ private:
+  Label m_title;
+  TextButton m_exportBtn;
+  TextButton m_resetBtn;
+  TableListBox m_table;
+  std::vector<RpcStats::MethodStats> m_stats;
+
+  void refresh() {
+    m_stats = RpcStats::getInstance()->getStats();
+    m_table.updateContent();
+    m_table.repaint();
+  }
+
+  void timerCallback() override {
+    if (isShowing())
+      refresh();
+  }
+};
+
 DebugPage::DebugPage() {
   m_tasksModel = TasksManager::getInstance()->getTasksModel();
   m_tasksModel->addListener(this);
@@ -83,6 +234,9 @@ DebugPage::DebugPage() {
   m_tasksListBox->setModel(this);
   addAndMakeVisible(m_tasksListBox.get());
 
+  m_rpcStatsComponent = std::make_unique<RpcStatsComponent>();
+  addAndMakeVisible(m_rpcStatsComponent.get());
+
   m_taskLogComponent = std::make_unique<TaskLogComponent>();
   addChildComponent(m_taskLogComponent.get());
 }
@@ -92,7 +246,9 @@ DebugPage::~DebugPage() {
 }
 
 void DebugPage::resized() {
-  m_tasksListBox->setBounds(getLocalBounds());
+  auto bounds = getLocalBounds();
+  m_rpcStatsComponent->setBounds(bounds.removeFromBottom(getHeight() / 2));
+  m_tasksListBox->setBounds(bounds);
   m_taskLogComponent->setBounds(getLocalBounds());
 }
 
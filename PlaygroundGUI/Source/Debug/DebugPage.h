@@ -23,6 +23,7 @@
 #include "JuceHeader.h"
 
 class TaskLogComponent;
+class RpcStatsComponent;
 
 class DebugPage : public Component,
                   public ListBoxModel,
@@ -41,5 +42,6 @@ class DebugPage : public Component,
  private:
   std::unique_ptr<ListBox> m_tasksListBox;
   std::unique_ptr<TaskLogComponent> m_taskLogComponent;
+  std::unique_ptr<RpcStatsComponent> m_rpcStatsComponent;
   std::shared_ptr<AsyncTaskModel> m_tasksModel;
 };
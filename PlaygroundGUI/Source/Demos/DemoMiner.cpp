@@ -18,30 +18,10 @@
  */
 
 #include "DemoMiner.h"
-
-static unsigned int leading_bits_char(char x) {
-  unsigned int c = 0;
-  while (x & 0x80) {
-    c++;
-    x <<= 1;
-  }
-  return c;
-}
+#include "../Utils/Bits256.h"
 
 using automaton::core::io::bin2hex;
 
-static unsigned int leading_bits(const std::string& s) {
-  unsigned int result = 0;
-  for (unsigned int i = 0; i < s.size(); i++) {
-    unsigned int lb = leading_bits_char(s[i]);
-    result += lb;
-    if (lb != 8) {
-      break;
-    }
-  }
-  return result;
-}
-
 static Colour HSV(double h, double s, double v) {
   double hh, p, q, t, ff;
   int64 i;
@@ -414,7 +394,7 @@ void DemoMiner::update() {
     unsigned int x = r[30] % m;
     unsigned int y = r[31] % n;
     // unsigned int r = rand_r(&my_seed) | mask;
-    auto lb = leading_bits(r);
+    auto lb = Bits256::countLeadingOnes(r);
     if ((lb >= initial_difficulty_bits) && (r > slots[x][y].diff)) {
       tx_count++;
       unsigned int reward = coeff * (t - slots[x][y].tm) * reward_per_period;
@@ -432,8 +412,8 @@ void DemoMiner::update() {
       slots[x][y].owner = ((rand() % 10000) < (mining_power * 100)) ? 1 : 0;
       slots[x][y].tm = t;
     }
-    if (leading_bits(r) > max_leading_bits) {
-      max_leading_bits = leading_bits(r);
+    if (lb > max_leading_bits) {
+      max_leading_bits = lb;
     }
   }
 }
@@ -20,10 +20,14 @@
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "MainComponent.h"
 #include "Data/AutomatonContractData.h"
+#include "Data/LocalRpcServer.h"
+#include "Data/RpcRecorder.h"
 #include "Login/LoginComponent.h"
+#include "Miner/MiningBenchmark.h"
 #include "automaton/core/io/io.h"
 
 #include <curl/curl.h>
+#include <iostream>
 
 class LoggerTest {
   std::unique_ptr<g3::LogWorker> logworker;
@@ -60,7 +64,10 @@ class PlaygroundGUIApplication: public JUCEApplication {
 
   const String getApplicationName() override       { return ProjectInfo::projectName; }
   const String getApplicationVersion() override    { return ProjectInfo::versionString; }
-  bool moreThanOneInstanceAllowed() override       { return false; }
+  bool moreThanOneInstanceAllowed() override {
+    const auto args = getCommandLineParameterArray();
+    return MiningBenchmark::isRequested(args) || LocalRpcServer::isRequested(args);
+  }
 
   //==============================================================================
   void initialise(const String& commandLine) override {
@@ -69,7 +76,22 @@ class PlaygroundGUIApplication: public JUCEApplication {
     testRunner.runAllTests();
 #endif
 
+    const auto args = getCommandLineParameterArray();
+    if (MiningBenchmark::isRequested(args)) {
+      runMiningBenchmark(MiningBenchmark::parseCommandLine(args));
+      return;
+    }
+
+    if (LocalRpcServer::isRequested(args)) {
+      runLocalRpcServer(LocalRpcServer::parseCommandLine(args));
+      return;
+    }
+
     curl_global_init(CURL_GLOBAL_ALL);
+    if (!RpcRecorder::getInstance()->startFromCommandLine(args)) {
+      quit();
+      return;
+    }
 
     m_fileLogger.reset(FileLogger::createDefaultAppLogger("automaton",
                                                           "automaton_log.txt",
@@ -83,8 +105,29 @@ class PlaygroundGUIApplication: public JUCEApplication {
     // LookAndFeel::getDefaultLookAndFeel().setDefaultSansSerifTypeface(typefacePlay);
   }
 
+  void runMiningBenchmark(const MiningBenchmark::Options& options) {
+    const auto report = MiningBenchmark::run(options);
+    if (options.outputFile != File())
+      options.outputFile.replaceWithText(report);
+    std::cout << report << std::endl;
+    quit();
+  }
+
+  // Serves without a window until the process is stopped.
+  void runLocalRpcServer(const LocalRpcServer::Options& options) {
+    m_rpcServer.reset(new LocalRpcServer(options));
+    if (!m_rpcServer->start()) {
+      std::cout << "ERROR: Can't listen on port " << options.port << std::endl;
+      quit();
+      return;
+    }
+    std::cout << "Serving " << options.model.numSlots << " slots, " << options.model.numProposals << " proposals and "
+              << options.model.numOrders << " orders on " << m_rpcServer->getUrl() << std::endl;
+  }
+
   void shutdown() override {
     mainWindow = nullptr;
+    m_rpcServer = nullptr;
     FileLogger::setCurrentLogger(nullptr);
     curl_global_cleanup();
   }
@@ -155,6 +198,7 @@ class PlaygroundGUIApplication: public JUCEApplication {
   EmbeddedFonts fonts;
   Typeface::Ptr typefacePlay;
   std::unique_ptr<FileLogger> m_fileLogger;
+  std::unique_ptr<LocalRpcServer> m_rpcServer;
 };
 
 //==============================================================================
@@ -140,7 +140,7 @@ void DemosMainComponent::resized() {
 
 void DemosMainComponent::buttonClicked(Button* button) {
   if (m_refreshButton.get() == button) {
-    m_accountData->getContractData()->readContract();
+    m_accountData->getContractData()->readContract(true);
   }
 }
 
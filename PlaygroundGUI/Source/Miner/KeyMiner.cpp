@@ -0,0 +1,212 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "KeyMiner.h"
+
+#include <cryptopp/osrng.h>
+#include <cstring>
+
+#include "JuceHeader.h"
+#include "Utils/Bits256.h"
+
+const int KeyMiner::BATCH_SIZE;
+
+static void loadWords(const unsigned char* bytes, uint64_t* words) {
+  for (int i = 0; i < 4; ++i)
+    words[i] = Bits256::loadWord(bytes + i * 8);
+}
+
+static void encodeScalar(uint64_t value, unsigned char* scalar) {
+  memset(scalar, 0, 32);
+  for (int i = 0; i < 8; ++i)
+    scalar[31 - i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+KeyMiner::KeyMiner(const unsigned char* mask, const unsigned char* difficulty)
+    : m_candidatesX(BATCH_SIZE)
+    , m_denominators(BATCH_SIZE)
+    , m_scratch(BATCH_SIZE) {
+  m_context = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+  loadWords(mask, m_mask);
+  loadWords(difficulty, m_difficulty);
+  reseed();
+}
+
+KeyMiner::~KeyMiner() {
+  secp256k1_context_destroy(m_context);
+}
+
+const std::vector<KeyMiner::AffinePoint>& KeyMiner::getMultiplesOfG() {
+  // 1*G ... BATCH_SIZE*G, shared by all miner threads.
+  static const std::vector<AffinePoint> multiples = [] {
+    std::vector<AffinePoint> points(BATCH_SIZE);
+    secp256k1_context* context = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    unsigned char scalar[32];
+    for (int i = 0; i < BATCH_SIZE; ++i) {
+      encodeScalar(static_cast<uint64_t>(i + 1), scalar);
+      secp256k1_pubkey pubkey;
+      unsigned char serialized[65];
+      size_t outLen = sizeof(serialized);
+      secp256k1_ec_pubkey_create(context, &pubkey, scalar);
+      secp256k1_ec_pubkey_serialize(context, serialized, &outLen, &pubkey, SECP256K1_EC_UNCOMPRESSED);
+      points[i].x = FieldElement::fromBytes(serialized + 1);
+      points[i].y = FieldElement::fromBytes(serialized + 33);
+    }
+    secp256k1_context_destroy(context);
+    return points;
+  }();
+  return multiples;
+}
+
+bool KeyMiner::loadPublicKey(const unsigned char* priv_key, AffinePoint* point) const {
+  secp256k1_pubkey pubkey;
+  if (!secp256k1_ec_pubkey_create(m_context, &pubkey, priv_key))
+    return false;
+
+  unsigned char serialized[65];
+  size_t outLen = sizeof(serialized);
+  secp256k1_ec_pubkey_serialize(m_context, serialized, &outLen, &pubkey, SECP256K1_EC_UNCOMPRESSED);
+  point->x = FieldElement::fromBytes(serialized + 1);
+  point->y = FieldElement::fromBytes(serialized + 33);
+  return true;
+}
+
+bool KeyMiner::reseed() {
+  CryptoPP::AutoSeededRandomPool rng;
+  do {
+    rng.GenerateBlock(m_basePrivateKey, sizeof(m_basePrivateKey));
+  } while (!secp256k1_ec_seckey_verify(m_context, m_basePrivateKey));
+
+  m_cursor = BATCH_SIZE;
+  return loadPublicKey(m_basePrivateKey, &m_base);
+}
+
+bool KeyMiner::computeBatch() {
+  const auto& multiples = getMultiplesOfG();
+
+  // Denominators of the affine addition slopes. A zero one means the base is +-i*G, which is practically impossible
+  // for a random base, but start over from a new one rather than divide by zero.
+  for (int i = 0; i < BATCH_SIZE; ++i) {
+    m_denominators[i] = multiples[i].x - m_base.x;
+    if (m_denominators[i].isZero())
+      return false;
+  }
+
+  FieldElement::batchInverse(m_denominators.data(), m_scratch.data(), BATCH_SIZE);
+
+  FieldElement lambda;
+  for (int i = 0; i < BATCH_SIZE; ++i) {
+    lambda = (multiples[i].y - m_base.y) * m_denominators[i];
+    m_candidatesX[i] = lambda.sqr() - m_base.x - multiples[i].x;
+  }
+
+  // The last candidate, K + BATCH_SIZE * G, becomes the base of the next batch.
+  const FieldElement& lastX = m_candidatesX[BATCH_SIZE - 1];
+  const FieldElement nextY = lambda * (m_base.x - lastX) - m_base.y;
+
+  memcpy(m_batchPrivateKey, m_basePrivateKey, sizeof(m_batchPrivateKey));
+  unsigned char tweak[32];
+  encodeScalar(BATCH_SIZE, tweak);
+  if (!secp256k1_ec_privkey_tweak_add(m_context, m_basePrivateKey, tweak))
+    return false;
+
+  m_base.x = lastX;
+  m_base.y = nextY;
+  m_cursor = 0;
+  return true;
+}
+
+bool KeyMiner::isAboveDifficulty(const FieldElement& x) const {
+  // Limbs are least significant first, the mask and the difficulty most significant first.
+  const uint64_t masked[4] = {x.d[3] ^ m_mask[0], x.d[2] ^ m_mask[1], x.d[1] ^ m_mask[2], x.d[0] ^ m_mask[3]};
+  return Bits256::compareWords(masked, m_difficulty) > 0;
+}
+
+int KeyMiner::mineKeys(unsigned int attempts, unsigned char* priv_key, unsigned char* pub_key_x) {
+  int checked = 0;
+  while (static_cast<unsigned int>(checked) < attempts) {
+    if (m_cursor == BATCH_SIZE && !computeBatch()) {
+      reseed();
+      continue;
+    }
+
+    const int index = m_cursor++;
+    ++checked;
+    if (!isAboveDifficulty(m_candidatesX[index]))
+      continue;
+
+    unsigned char tweak[32];
+    encodeScalar(static_cast<uint64_t>(index + 1), tweak);
+    memcpy(priv_key, m_batchPrivateKey, 32);
+    if (!secp256k1_ec_privkey_tweak_add(m_context, priv_key, tweak))
+      continue;
+
+    // Found keys are rare, so double check the batch arithmetic with a regular key derivation before reporting one.
+    AffinePoint point;
+    if (!loadPublicKey(priv_key, &point) || !(point.x == m_candidatesX[index]))
+      continue;
+
+    m_candidatesX[index].toBytes(pub_key_x);
+    return checked;
+  }
+
+  return -checked;
+}
+
+#if AUTOMATON_JUCE_UNIT_TESTS
+class KeyMinerTest : public UnitTest {
+ public:
+  KeyMinerTest() : UnitTest("KeyMiner") {
+  }
+
+  void runTest() override {
+    beginTest("Field inverse");
+    unsigned char bytes[32];
+    for (int i = 0; i < 32; ++i)
+      bytes[i] = static_cast<unsigned char>(0xA5 ^ (i * 7));
+    const FieldElement a = FieldElement::fromBytes(bytes);
+    const FieldElement one = {{1, 0, 0, 0}};
+    expect(a * a.inverse() == one);
+    expect(a - a == FieldElement::zero());
+
+    beginTest("Batched keys match their private keys");
+    unsigned char mask[32] = {0};
+    unsigned char difficulty[32] = {0};
+    KeyMiner keyMiner(mask, difficulty);
+    secp256k1_context* context = secp256k1_context_create(SECP256K1_CONTEXT_SIGN);
+    unsigned char pk[32];
+    unsigned char x[32];
+    // Crosses two batch boundaries, every candidate beats a zero difficulty.
+    for (int i = 0; i < 2 * KeyMiner::BATCH_SIZE + 2; ++i) {
+      expectEquals(keyMiner.mineKeys(1, pk, x), 1);
+      if (i % 97 == 0) {
+        secp256k1_pubkey pubkey;
+        unsigned char serialized[65];
+        size_t outLen = sizeof(serialized);
+        expect(secp256k1_ec_pubkey_create(context, &pubkey, pk) == 1);
+        secp256k1_ec_pubkey_serialize(context, serialized, &outLen, &pubkey, SECP256K1_EC_UNCOMPRESSED);
+        expect(memcmp(serialized + 1, x, 32) == 0);
+      }
+    }
+    secp256k1_context_destroy(context);
+  }
+};
+
+static KeyMinerTest test;
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <secp256k1.h>
+#include <vector>
+
+#include "Secp256k1Field.h"
+
+// Batched King of the Hill key miner. One instance per miner thread, it is not thread safe.
+//
+// Instead of generating and multiplying a fresh random private key per attempt, the miner walks consecutive private
+// keys k + 1 ... k + BATCH_SIZE. Their public keys are the base point K plus a shared table of multiples of G, and all
+// the affine additions of a batch share one field inversion (Montgomery's trick). Only the X coordinate of each
+// candidate is computed; the private key is derived from the batch base when a candidate beats the difficulty.
+class KeyMiner {
+ public:
+  static const int BATCH_SIZE = 1024;
+
+  KeyMiner(const unsigned char* mask, const unsigned char* difficulty);
+  ~KeyMiner();
+
+  // Checks up to `attempts` candidate keys. Returns the number of keys checked, positive if a key whose masked
+  // public key X is above the difficulty was found and negative otherwise (the automaton::tools::miner::mine_key
+  // convention). A found key is written to priv_key and its public key X to pub_key_x, 32 bytes each.
+  int mineKeys(unsigned int attempts, unsigned char* priv_key, unsigned char* pub_key_x);
+
+ private:
+  struct AffinePoint {
+    FieldElement x;
+    FieldElement y;
+  };
+
+  static const std::vector<AffinePoint>& getMultiplesOfG();
+
+  bool loadPublicKey(const unsigned char* priv_key, AffinePoint* point) const;
+  bool reseed();
+  bool computeBatch();
+  bool isAboveDifficulty(const FieldElement& x) const;
+
+  secp256k1_context* m_context;
+  uint64_t m_mask[4];
+  uint64_t m_difficulty[4];
+
+  // Private key and public key of the point the next batch is added to.
+  unsigned char m_basePrivateKey[32];
+  AffinePoint m_base;
+
+  // Private key of the base the current batch was computed from; candidate i is m_batchPrivateKey + i + 1.
+  unsigned char m_batchPrivateKey[32];
+  std::vector<FieldElement> m_candidatesX;
+  std::vector<FieldElement> m_denominators;
+  std::vector<FieldElement> m_scratch;
+  int m_cursor = BATCH_SIZE;
+};
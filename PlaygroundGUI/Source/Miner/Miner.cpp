@@ -17,11 +17,15 @@
  * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <json.hpp>
 
 #include "Miner.h"
 #include "../Data/AutomatonContractData.h"
+#include "Utils/Bits256.h"
+#include "Utils/Uint256.h"
 #include "Utils/Utils.h"
 #include "Utils/TasksManager.h"
 
@@ -43,33 +47,12 @@ using automaton::core::io::dec2hex;
 using automaton::core::io::hex2bin;
 using automaton::core::io::hex2dec;
 using automaton::tools::miner::gen_pub_key;
-using automaton::tools::miner::mine_key;
 using automaton::tools::miner::sign;
 
 
 static const int OWNER_SLOT_HUE = 122;
 static const int NON_OWNER_SLOT_HUE = 200;
 
-static std::string get_pub_key_x(const unsigned char* priv_key) {
-  secp256k1_context* context = secp256k1_context_create(SECP256K1_CONTEXT_SIGN | SECP256K1_CONTEXT_VERIFY);
-  secp256k1_pubkey* pubkey = new secp256k1_pubkey();
-
-  if (!secp256k1_ec_pubkey_create(context, pubkey, priv_key)) {
-    LOG(WARNING) << "Invalid priv_key " << bin2hex(std::string(reinterpret_cast<const char*>(priv_key), 32));
-    delete pubkey;
-    secp256k1_context_destroy(context);
-    return "";
-  }
-
-  unsigned char pub_key_serialized[65];
-  size_t outLen = 65;
-  secp256k1_ec_pubkey_serialize(context, pub_key_serialized, &outLen, pubkey, SECP256K1_EC_UNCOMPRESSED);
-  std::string pub_key_uncompressed(reinterpret_cast<char*>(pub_key_serialized), 65);
-  delete pubkey;
-  secp256k1_context_destroy(context);
-  return std::string(reinterpret_cast<char*>(pub_key_serialized+1), 32);
-}
-
 static Colour HSV(double h, double s, double v) {
   double hh, p, q, t, ff;
   int64 i;
@@ -113,23 +96,6 @@ static Colour HSV(double h, double s, double v) {
   return Colour(uint8(r * 255), uint8(g * 255), uint8(b * 255));
 }
 
-static uint32_t leadingBits(const std::string& s) {
-  uint32_t result = 0;
-  for (uint32_t i = 0; i < s.size(); ++i) {
-    uint8_t x = s[i];
-    if (x == 0xFF) {
-      result += 8;
-    } else {
-      while (x & 0x80) {
-        result++;
-        x <<= 1;
-      }
-      break;
-    }
-  }
-  return result;
-}
-
 class ValidatorSlotsLegend : public Component {
  public:
   void paint(Graphics& g) override;
@@ -149,35 +115,45 @@ class ValidatorSlotsGrid : public SlotsGrid {
     return { m_minLeadingBits, m_maxLeadingBits };
   }
 
+  size_t getNumOfOwnedSlots() const noexcept {
+    return m_numOfOwnedSlots;
+  }
+
   void setCurrentAccountAddress(const String& accountOwnerAddress) {
-    m_owner = accountOwnerAddress.toStdString();
+    ValidatorSlots::parseOwner(accountOwnerAddress.toStdString(), m_owner);
   }
 
-  void setSlots(const std::vector<ValidatorSlot>& validatorSlots) {
-    m_minLeadingBits = 257;
-    m_maxLeadingBits = 0;
+  // Only the changed slots are recomputed and repainted, unless the range of leading bits that sets the colours moved.
+  void setSlots(std::shared_ptr<const ValidatorSlots> validatorSlots, const ContractChanges& changes) {
+    const bool all = changes.allSlots || m_validatorSlots == nullptr || validatorSlots->size() != m_slots.size();
+    m_validatorSlots = validatorSlots;
 
-    if (validatorSlots.size() != m_slots.size())
-      m_slots.resize(validatorSlots.size());
+    if (all) {
+      m_slots.assign(validatorSlots->size(), Slot());
+      m_bitsCount.fill(0);
+      m_bitsCount[0] = static_cast<uint32>(m_slots.size());
+      m_numOfOwnedSlots = 0;
+      for (size_t i = 0; i < m_slots.size(); ++i)
+        updateSlot(i);
 
-    for (int i = 0; i < m_slots.size(); ++i) {
-      const auto& slot = validatorSlots[i];
-      if (slot.difficulty != m_slots[i].difficulty) {
-        m_slots[i].owner = slot.owner;
-        m_slots[i].difficulty = slot.difficulty;
-        m_slots[i].isMine = slot.owner == m_owner;
-        m_slots[i].bits = leadingBits(slot.difficulty);
-      }
+      updateLeadingBitsRange();
+      updateContent();
+      return;
+    }
 
-      if (m_slots[i].bits && m_slots[i].bits < m_minLeadingBits) {
-        m_minLeadingBits = m_slots[i].bits;
-      }
-      if (m_slots[i].bits > m_maxLeadingBits) {
-        m_maxLeadingBits = m_slots[i].bits;
-      }
+    for (int i = 0; i < changes.slots.getNumRanges(); ++i) {
+      const auto range = changes.slots.getRange(i);
+      for (int slot = range.getStart(); slot < range.getEnd(); ++slot)
+        updateSlot(slot);
     }
 
-    updateContent();
+    const auto previousRange = getLeadingBitsRange();
+    updateLeadingBitsRange();
+    if (getLeadingBitsRange() != previousRange) {
+      repaint();
+    } else {
+      repaintSlots(changes.slots);
+    }
   }
 
   Colour getSlotColour(int slotIndex, bool isHighlighted) override {
@@ -208,11 +184,10 @@ class ValidatorSlotsGrid : public SlotsGrid {
     if (slotIndex < 0)
       return nullptr;
 
-    const auto vote = m_slots[slotIndex];
     String slotInfo;
     slotInfo << "Slot: " << slotIndex << "\n" <<
-             "Owner: " << m_slots[slotIndex].owner << "\n" <<
-             "Difficulty:" << bin2hex(m_slots[slotIndex].difficulty) << "\n"
+             "Owner: " << m_validatorSlots->getOwnerHex(slotIndex) << "\n" <<
+             "Difficulty:" << Uint256::fromBigEndian(m_validatorSlots->getDifficulty(slotIndex)).toHex() << "\n"
              "Difficulty bits:" << String(m_slots[slotIndex].bits) << "\n";
 
     m_popup.m_label.setText(slotInfo, NotificationType::dontSendNotification);
@@ -224,15 +199,43 @@ class ValidatorSlotsGrid : public SlotsGrid {
  private:
   uint32 m_minLeadingBits = 257;
   uint32 m_maxLeadingBits = 0;
-  std::string m_owner;
+  unsigned char m_owner[ValidatorSlots::OWNER_SIZE] = {0};
 
+  // Derived per slot state, recomputed only for the slots that changed.
   struct Slot {
-    std::string difficulty;
-    std::string owner;
     bool isMine = false;
     uint32_t bits = 0;
   };
   std::vector<Slot> m_slots;
+  std::shared_ptr<const ValidatorSlots> m_validatorSlots;
+  // Number of slots per leading bits count, keeps the range of leading bits without scanning all slots.
+  std::array<uint32, 257> m_bitsCount {};
+  size_t m_numOfOwnedSlots = 0;
+
+  void updateSlot(size_t i) {
+    auto& slot = m_slots[i];
+    --m_bitsCount[slot.bits];
+    if (slot.isMine)
+      --m_numOfOwnedSlots;
+
+    slot.isMine = m_validatorSlots->isOwnedBy(i, m_owner);
+    slot.bits = Bits256::countLeadingOnes(m_validatorSlots->getDifficulty(i), ValidatorSlots::DIFFICULTY_SIZE);
+
+    ++m_bitsCount[slot.bits];
+    if (slot.isMine)
+      ++m_numOfOwnedSlots;
+  }
+
+  void updateLeadingBitsRange() {
+    m_minLeadingBits = 257;
+    m_maxLeadingBits = 0;
+    for (uint32 bits = 1; bits < m_bitsCount.size(); ++bits) {
+      if (m_bitsCount[bits] > 0) {
+        m_minLeadingBits = jmin(m_minLeadingBits, bits);
+        m_maxLeadingBits = bits;
+      }
+    }
+  }
 
   class SlotPopup : public Component {
    public:
@@ -315,68 +318,105 @@ void ValidatorSlotsLegend::setLeadingBitsRange(Range<uint32> leadingBitsRange) {
   repaint();
 }
 
-void Miner::addMinerThread() {
-  auto miner = TasksManager::launchTask([=](AsyncTask* task) {
-    uint64 keysMined = 0;
-    int64 startTime;
-
-    startTime = Time::getCurrentTime().toMilliseconds();
+void Miner::startMining() {
+  m_miningScheduler.start(getMask(), getDifficulty());
+}
 
-    unsigned char mask[32];
-    unsigned char difficulty[32];
-    unsigned char pk[32];
+void Miner::addMinerThread() {
+  m_miningScheduler.addThread(getMask(), getDifficulty());
+}
 
-    memcpy(mask, getMask(), 32);
-    memcpy(difficulty, getDifficulty(), 32);
+void Miner::stopMining() {
+  m_miningScheduler.stop();
+}
 
-    while (!task->threadShouldExit()) {
-      unsigned int keys_generated = mine_key(mask, difficulty, pk, 1000);
-      processMinedKey(std::string(reinterpret_cast<const char*>(pk), 32), keys_generated);
-    }
+// Big-endian a - b of two 32 byte difficulties, zero if a doesn't beat b. A missing difficulty counts as zero.
+static std::string difficultyMargin(const std::string& a, const unsigned char* b) {
+  std::string margin(32, '\0');
+  const unsigned char zero[32] = {0};
+  const auto bytes = reinterpret_cast<const unsigned char*>(a.data());
+  if (a.size() != 32 || !Bits256::isGreater(bytes, b != nullptr ? b : zero)) {
+    return margin;
+  }
 
-    return true;
-  }, nullptr, "Miner Thread", m_accountData, false);
+  Bits256::subtract(bytes, b != nullptr ? b : zero, reinterpret_cast<unsigned char*>(&margin[0]));
+  return margin;
+}
 
-  miners.add(miner);
+void Miner::resetMinedSlots() {
+  mined_slots.assign(totalSlots, mined_slot());
+  m_numMinedSlots = 0;
 }
 
-void Miner::stopMining() {
-  for (int i = 0; i < miners.size(); ++i) {
-    miners[i]->signalThreadShouldExit();
+void Miner::pruneMinedSlot(size_t i, const ValidatorSlots& validatorSlots) {
+  auto& ms = mined_slots[i];
+  if (ms.difficulty.empty()) {
+    return;
   }
-
-  for (int i = 0; i < miners.size(); ++i) {
-    miners[i]->waitForThreadToExit(-1);
+  if (i >= validatorSlots.size() || !Bits256::isGreater(
+        reinterpret_cast<const unsigned char*>(ms.difficulty.data()), validatorSlots.getDifficulty(i))) {
+    ms = mined_slot();
+    --m_numMinedSlots;
   }
-
-  miners.clear();
 }
 
-void Miner::processMinedKey(std::string _pk, int keys_generated) {
-  auto cd = m_accountData->getContractData();
-  ScopedLock lock(cd->m_criticalSection);
-
-  total_keys_generated += abs(keys_generated);
-  if (keys_generated <= 0) {
+void Miner::pruneMinedSlots(const ValidatorSlots& validatorSlots, const ContractChanges& changes) {
+  // Drop keys that no longer beat the owner of their slot.
+  if (changes.allSlots) {
+    for (size_t i = 0; i < mined_slots.size() && m_numMinedSlots > 0; ++i)
+      pruneMinedSlot(i, validatorSlots);
     return;
   }
-  mined_slot ms;
-  std::string x = get_pub_key_x(reinterpret_cast<const unsigned char *>(_pk.c_str()));
-  ms.public_key = x;
-  CryptoPP::Integer bn_x((bin2hex(x) + "h").c_str());
-  ms.slot_index = uint32_t(bn_x % totalSlots);
-  for (int i = 0; i < 32; i++) {
-    x[i] ^= mask[i];
+
+  for (int r = 0; r < changes.slots.getNumRanges() && m_numMinedSlots > 0; ++r) {
+    const auto range = changes.slots.getRange(r);
+    for (size_t i = range.getStart(); i < static_cast<size_t>(range.getEnd()) && i < mined_slots.size(); ++i)
+      pruneMinedSlot(i, validatorSlots);
   }
-  if (x <= std::string(reinterpret_cast<char*>(difficulty), 32)) {
+}
+
+void Miner::drainMinedKeys() {
+  MinerPool::mined_key key;
+  if (!m_minerPool.popMinedKey(&key)) {
     return;
   }
-  if (x <= cd->m_slots[ms.slot_index].difficulty) {
+
+  if (totalSlots == 0) {
+    while (m_minerPool.popMinedKey(&key)) {}
     return;
   }
-  ms.difficulty = x;
-  ms.private_key = _pk;
-  mined_slots.push_back(ms);
+
+  // The snapshot stays the same for the whole drain, no lock needed.
+  const auto snapshot = m_accountData->getContractData()->getSnapshot();
+  const auto& slots = snapshot->slots;
+
+  unsigned char masked[32];
+  do {
+    Bits256::maskXor(key.public_key_x, mask, masked);
+    if (!Bits256::isGreater(masked, difficulty)) {
+      continue;
+    }
+
+    mined_slot ms;
+    ms.public_key = std::string(reinterpret_cast<const char*>(key.public_key_x), 32);
+    ms.slot_index = Uint256::fromBigEndian(key.public_key_x).mod(totalSlots);
+    if (ms.slot_index >= slots.size() || !Bits256::isGreater(masked, slots.getDifficulty(ms.slot_index))) {
+      continue;
+    }
+
+    // Keep only the strongest key per slot.
+    auto& best = mined_slots[ms.slot_index];
+    if (!best.difficulty.empty()
+        && !Bits256::isGreater(masked, reinterpret_cast<const unsigned char*>(best.difficulty.data()))) {
+      continue;
+    }
+    if (best.difficulty.empty()) {
+      ++m_numMinedSlots;
+    }
+    ms.difficulty = std::string(reinterpret_cast<const char*>(masked), 32);
+    ms.private_key = std::string(reinterpret_cast<const char*>(key.private_key), 32);
+    best = ms;
+  } while (m_minerPool.popMinedKey(&key));
 }
 
 class TableSlots: public TableListBox, TableListBoxModel {
@@ -429,8 +469,7 @@ class TableSlots: public TableListBox, TableListBoxModel {
 
   // This is overloaded from TableListBoxModel, and must return the total number of rows in our table
   int getNumRows() override {
-    ScopedLock lock(contractData->m_criticalSection);
-    return static_cast<int>(contractData->m_slots.size());
+    return static_cast<int>(contractData->getSnapshot()->slots.size());
   }
 
   void selectedRowsChanged(int) override {
@@ -451,7 +490,7 @@ class TableSlots: public TableListBox, TableListBoxModel {
   // components.
   void paintCell(Graphics& g, int rowNumber, int columnId,
                 int width, int height, bool /*rowIsSelected*/) override {
-    ScopedLock lock(contractData->m_criticalSection);
+    const auto snapshot = contractData->getSnapshot();
 
     g.setColour(getLookAndFeel().findColour(ListBox::textColourId));
     g.setFont(font);
@@ -467,11 +506,16 @@ class TableSlots: public TableListBox, TableListBoxModel {
         break;
       }
       case 2: {
-        text = bin2hex(contractData->m_slots[rowNumber].difficulty);
+        if (static_cast<size_t>(rowNumber) < snapshot->slots.size()) {
+          char hex[Uint256::HEX_DIGITS];
+          Uint256::fromBigEndian(snapshot->slots.getDifficulty(rowNumber)).toHex(hex);
+          text = String(hex, sizeof(hex));
+        }
         break;
       }
       case 3: {
-        text = "0x" + contractData->m_slots[rowNumber].owner;
+        if (static_cast<size_t>(rowNumber) < snapshot->slots.size())
+          text = "0x" + snapshot->slots.getOwnerHex(rowNumber);
         break;
       }
       case 4: {
@@ -491,29 +535,6 @@ class TableSlots: public TableListBox, TableListBoxModel {
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TableSlots)
 };
 
-static unsigned int leading_bits_char(char x) {
-  unsigned int c = 0;
-  while (x & 0x80) {
-    c++;
-    x <<= 1;
-  }
-  return c;
-}
-
-using automaton::core::io::bin2hex;
-
-unsigned int leading_bits(const std::string& s) {
-  unsigned int result = 0;
-  for (unsigned int i = 0; i < s.size(); i++) {
-    unsigned int lb = leading_bits_char(s[i]);
-    result += lb;
-    if (lb != 8) {
-      break;
-    }
-  }
-  return result;
-}
-
 static String sepitoa(uint64 n, bool lz = false) {
   if (n < 1000) {
     if (!lz) {
@@ -537,7 +558,10 @@ static std::unique_ptr<Label> createLabel(const String& text, Component* parent)
 }
 
 //==============================================================================
-Miner::Miner(Account::Ptr accountData) : m_accountData(accountData) {
+Miner::Miner(Account::Ptr accountData)
+    : m_accountData(accountData)
+    , m_minerPool(accountData)
+    , m_miningScheduler(&m_minerPool) {
   m_accountData->getContractData()->addChangeListener(this);
   private_key = m_accountData->getPrivateKey();
   eth_address = m_accountData->getAddress();
@@ -562,6 +586,9 @@ Miner::Miner(Account::Ptr accountData) : m_accountData(accountData) {
   m_minDifficultyHexEditor->setReadOnly(true);
   addAndMakeVisible(m_minDifficultyHexEditor.get());
 
+  m_startMiningBtn = std::make_unique<TextButton>("Start Mining");
+  addAndMakeVisible(m_startMiningBtn.get());
+  m_startMiningBtn->addListener(this);
   m_addMinerBtn = std::make_unique<TextButton>("Add Miner");
   addAndMakeVisible(m_addMinerBtn.get());
   m_addMinerBtn->addListener(this);
@@ -596,30 +623,40 @@ Miner::Miner(Account::Ptr accountData) : m_accountData(accountData) {
   startTimer(1000);
 }
 
-void Miner::setNumOfOwnedSlots(const std::vector<ValidatorSlot>& validatorSlots) {
-  uint64 numOfOwnedSlots = 0;
-  const auto accountAddress = String(m_accountData->getAddress()).substring(2);
-
-  for (const auto& slot : validatorSlots) {
-    if (slot.owner == accountAddress) {
-      ++numOfOwnedSlots;
-    }
-  }
-
+void Miner::setNumOfOwnedSlots(size_t numOfOwnedSlots) {
   m_ownedSlotsNumEditor->setText("Owned slots: " + String(numOfOwnedSlots), NotificationType::dontSendNotification);
 }
 
 void Miner::updateContractData() {
-  auto cd = m_accountData->getContractData();
-  ScopedLock lock(cd->m_criticalSection);
+  const auto snapshot = m_accountData->getContractData()->getSnapshot();
+  if (snapshot->version == m_contractVersion)
+    return;
 
-  m_validatorSlotsGrid->setSlots(cd->m_slots);
-  setNumOfOwnedSlots(cd->m_slots);
+  const auto changes = snapshot->getChangesSince(m_contractVersion);
+  m_contractVersion = snapshot->version;
+  const std::shared_ptr<const ValidatorSlots> slots(snapshot, &snapshot->slots);
+
+  m_validatorSlotsGrid->setSlots(slots, changes);
+  setNumOfOwnedSlots(m_validatorSlotsGrid->getNumOfOwnedSlots());
   m_validatorSlotsLegend->setLeadingBitsRange(m_validatorSlotsGrid->getLeadingBitsRange());
 
-  setSlotsNumber(cd->m_slotsNumber);
-  setMaskHex(cd->m_mask);
-  setMinDifficultyHex(cd->m_minDifficulty);
+  if (changes.hasField(ContractChanges::SLOTS_NUMBER))
+    setSlotsNumber(snapshot->slotsNumber);
+  if (changes.hasField(ContractChanges::MASK))
+    setMaskHex(snapshot->mask);
+  if (changes.hasField(ContractChanges::MIN_DIFFICULTY))
+    setMinDifficultyHex(snapshot->minDifficulty);
+  pruneMinedSlots(*slots, changes);
+
+  if (changes.allSlots) {
+    m_tblSlots->updateContent();
+  } else {
+    for (int r = 0; r < changes.slots.getNumRanges(); ++r) {
+      const auto range = changes.slots.getRange(r);
+      for (int row = range.getStart(); row < range.getEnd(); ++row)
+        m_tblSlots->repaintRow(row);
+    }
+  }
 }
 
 Miner::~Miner() {
@@ -640,33 +677,35 @@ void Miner::setMask(std::string _mask) {
 }
 */
 
+// Hex that doesn't parse, e.g. an empty config, reads as zero.
 void Miner::setMaskHex(std::string _mask) {
-  auto mask_bin = hex2bin(_mask);
-  memcpy(mask, mask_bin.c_str(), sizeof(mask));
+  Uint256 value;
+  Uint256::fromHex(_mask, &value);
+  value.toBigEndian(mask);
   m_maskHexEditor->setText(_mask);
 }
 
 void Miner::setMinDifficultyHex(std::string _minDifficulty) {
-  auto diff_bin = hex2bin(_minDifficulty);
-  memcpy(difficulty, diff_bin.c_str(), sizeof(difficulty));
+  Uint256 value;
+  Uint256::fromHex(_minDifficulty, &value);
+  value.toBigEndian(difficulty);
   m_minDifficultyHexEditor->setText(_minDifficulty, false);
 }
 
 void Miner::setMinerAddress(std::string _address) {
-  if (_address.substr(0, 2) == "0x") {
-    _address = _address.substr(2);
-  }
-  _address += "h";
-  CryptoPP::Integer a(_address.c_str());
-
-  a.Encode(minerAddress, 32);
-  const unsigned int UPPER = (1 << 31);
+  Uint256 value;
+  Uint256::fromHex(_address, &value);
+  value.toBigEndian(minerAddress);
   // txtMinerAddress->setText("0x" + IntToString(a, UPPER | 16), false);
 }
 
 void Miner::setSlotsNumber(int _slotsNum) {
   _slotsNum = jmax(0, jmin(65536, _slotsNum));
   totalSlots = _slotsNum;
+  // Slot indices of mined keys depend on the number of slots.
+  if (mined_slots.size() != totalSlots) {
+    resetMinedSlots();
+  }
   m_slotsNumEditor->setText(String(totalSlots), false);
   repaint();
   m_tblSlots->updateContent();
@@ -675,7 +714,7 @@ void Miner::setSlotsNumber(int _slotsNum) {
 
 void Miner::initSlots() {
   unsigned char difficulty[32];
-  mined_slots.clear();
+  resetMinedSlots();
 
   memset(mask, 0, 32);
   memset(difficulty, 0, 32);
@@ -696,7 +735,9 @@ void Miner::changeListenerCallback(ChangeBroadcaster* source) {
 
 void Miner::buttonClicked(Button* btn) {
   auto txt = btn->getButtonText();
-  if (txt == "Add Miner") {
+  if (txt == "Start Mining") {
+    startMining();
+  } else if (txt == "Add Miner") {
     addMinerThread();
   } else if (txt == "Stop Miners") {
     stopMining();
@@ -739,9 +780,11 @@ void Miner::resized() {
   auto infoBounds = detailsBounds.removeFromTop(70);
   infoBounds.removeFromLeft(100);
   auto buttonsBounds = infoBounds.removeFromLeft(200).withTrimmedRight(10);
-  const auto buttonHeight = (infoBounds.getHeight() - 10) / 2;
+  const auto buttonHeight = (infoBounds.getHeight() - 10) / 3;
+  m_startMiningBtn->setBounds(buttonsBounds.removeFromTop(buttonHeight));
+  buttonsBounds.removeFromTop(5);
   m_addMinerBtn->setBounds(buttonsBounds.removeFromTop(buttonHeight));
-  buttonsBounds.removeFromTop(10);
+  buttonsBounds.removeFromTop(5);
   m_stopMinerBtn->setBounds(buttonsBounds.removeFromTop(buttonHeight));
   m_minerInfoEditor->setBounds(infoBounds.removeFromLeft(300));
 
@@ -758,22 +801,43 @@ void Miner::resized() {
 void Miner::update() {
   auto cur_time = Time::getCurrentTime().toMilliseconds();
   auto delta = cur_time - last_time;
+  const auto total_keys_generated = m_minerPool.getTotalKeysGenerated();
   auto delta_keys = total_keys_generated - last_keys_generated;
-  if (total_keys_generated > 0) {
+  if (total_keys_generated > 0 && delta > 0) {
+    const auto dropped_keys = m_minerPool.getDroppedKeys();
     m_minerInfoEditor->setText(
       "Total keys generated: " + String(total_keys_generated) + "\n" +
       "Mining power: " + String(delta_keys * 1000 / delta) + " keys/s\n" +
-      "Mined unclaimed keys: " + String(mined_slots.size()) + "\n" +
-      "Active miners: " + String(miners.size()));
+      "Mined unclaimed keys: " + String(m_numMinedSlots) + "\n" +
+      "Active miners: " + String(m_minerPool.size()) +
+      (m_miningScheduler.isCalibrating() ? " (calibrating)" : String()) +
+      (dropped_keys > 0 ? "\nDropped keys: " + String(dropped_keys) : String()));
   }
   last_time = cur_time;
   last_keys_generated = total_keys_generated;
 }
 
 void Miner::claimMinedSlots() {
-  if (mined_slots.size() > 0) {
-    auto ms = mined_slots.back();
-    mined_slots.pop_back();
+  if (m_numMinedSlots > 0) {
+    // Claim the key with the largest difficulty margin over the current owner first.
+    size_t bestSlot = 0;
+    std::string bestMargin;
+    const auto slots = m_accountData->getContractData()->getSlots();
+    for (size_t i = 0; i < mined_slots.size(); ++i) {
+      if (mined_slots[i].difficulty.empty()) {
+        continue;
+      }
+      const auto margin = difficultyMargin(mined_slots[i].difficulty,
+                                           i < slots->size() ? slots->getDifficulty(i) : nullptr);
+      if (bestMargin.empty() || margin > bestMargin) {
+        bestSlot = i;
+        bestMargin = margin;
+      }
+    }
+
+    auto ms = mined_slots[bestSlot];
+    mined_slots[bestSlot] = mined_slot();
+    --m_numMinedSlots;
 
     auto mined_key = ms.private_key;
 
@@ -814,6 +878,8 @@ void Miner::claimMinedSlots() {
 }
 
 void Miner::timerCallback() {
+  m_miningScheduler.update();
+  drainMinedKeys();
   claimMinedSlots();
   update();
   repaint();
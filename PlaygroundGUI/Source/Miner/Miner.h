@@ -24,6 +24,8 @@
 #include <Data/AutomatonContractData.h>
 #include "../../JuceLibraryCode/JuceHeader.h"
 #include "Components/FormMaker.h"
+#include "MinerPool.h"
+#include "MiningScheduler.h"
 
 #include "automaton/core/crypto/cryptopp/secure_random_cryptopp.h"
 #include "automaton/core/crypto/cryptopp/SHA256_cryptopp.h"
@@ -61,17 +63,18 @@ class Miner : public Component,
     std::string difficulty;
     std::string public_key;
     std::string private_key;
-    uint32_t slot_index;
+    uint32_t slot_index = 0;
   };
 
   void initSlots();
-  void processMinedKey(std::string _pk, int keys_generated);
 
+  void startMining();
   void addMinerThread();
   void stopMining();
 
-  size_t getMinedSlotsNumber() { return mined_slots.size(); }
-  mined_slot& getMinedSlot(int _slot) { return mined_slots[_slot]; }
+  // Best unclaimed key per slot, the difficulty of a slot without one is empty.
+  size_t getMinedSlotsNumber() { return m_numMinedSlots; }
+  const mined_slot& getMinedSlot(int _slot) { return mined_slots[_slot]; }
   unsigned char* getMask() { return mask; }
   unsigned char* getDifficulty() { return difficulty; }
 
@@ -87,13 +90,15 @@ class Miner : public Component,
 
   // Mining
   uint32 totalSlots = 1024;
-  std::vector<mined_slot> mined_slots;
+  std::vector<mined_slot> mined_slots;  // Indexed by slot, sized from totalSlots
+  size_t m_numMinedSlots = 0;
+  uint64 m_contractVersion = 0;
+  MinerPool m_minerPool;
+  MiningScheduler m_miningScheduler;
 
-  unsigned int total_keys_generated = 0;
-  unsigned int last_keys_generated = 0;
+  uint64 last_keys_generated = 0;
   unsigned int slots_claimed = 0;
   int64 last_time = 0;
-  Array<AsyncTask::Ptr> miners;
   unsigned char mask[32];
   unsigned int min_difficulty;
   unsigned char difficulty[32];
@@ -117,6 +122,7 @@ class Miner : public Component,
   std::unique_ptr<TextEditor> m_minerInfoEditor;
   std::unique_ptr<TextEditor> m_claimEditor;
 
+  std::unique_ptr<TextButton> m_startMiningBtn;
   std::unique_ptr<TextButton> m_addMinerBtn;
   std::unique_ptr<TextButton> m_stopMinerBtn;
 
@@ -124,8 +130,13 @@ class Miner : public Component,
   std::unique_ptr<ValidatorSlotsGrid> m_validatorSlotsGrid;
   std::unique_ptr<ValidatorSlotsLegend> m_validatorSlotsLegend;
 
-  void setNumOfOwnedSlots(const std::vector<ValidatorSlot>& validatorSlots);
+  void setNumOfOwnedSlots(size_t numOfOwnedSlots);
+  // Applies the changes since the last processed contract snapshot.
   void updateContractData();
+  void resetMinedSlots();
+  void pruneMinedSlot(size_t i, const ValidatorSlots& validatorSlots);
+  void pruneMinedSlots(const ValidatorSlots& validatorSlots, const ContractChanges& changes);
+  void drainMinedKeys();
   void claimMinedSlots();
 
   void timerCallback() override;
@@ -0,0 +1,129 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <cstring>
+
+#include "MinerPool.h"
+#include "KeyMiner.h"
+#include "Utils/TasksManager.h"
+
+MinerPool::MinerPool(Account::Ptr account) : m_account(account) {
+}
+
+MinerPool::~MinerPool() {
+  stop();
+}
+
+void MinerPool::addMinerThread(const unsigned char* mask, const unsigned char* difficulty, int cpu) {
+  std::array<unsigned char, 32> minerMask;
+  std::array<unsigned char, 32> minerDifficulty;
+  memcpy(minerMask.data(), mask, 32);
+  memcpy(minerDifficulty.data(), difficulty, 32);
+
+  auto stats = m_threadStats.add(new thread_stats());
+  const bool profiling = m_profilingEnabled;
+  auto miner = TasksManager::launchTask([=](AsyncTask* task) {
+    // JUCE affinity masks only cover the first 32 CPUs.
+    if (cpu >= 0 && cpu < 32)
+      Thread::setCurrentThreadAffinityMask(1u << cpu);
+
+    KeyMiner keyMiner(minerMask.data(), minerDifficulty.data());
+    mined_key key;
+    while (!task->threadShouldExit()) {
+      int keys_generated = keyMiner.mineKeys(KeyMiner::BATCH_SIZE, key.private_key, key.public_key_x);
+      if (profiling) {
+        const auto start = Time::getHighResolutionTicks();
+        processMinedKey(key, keys_generated, stats);
+        const auto ticks = Time::getHighResolutionTicks() - start;
+        stats->process_times_ns.push_back(
+            static_cast<uint32>(Time::highResolutionTicksToSeconds(ticks) * 1e9));
+      } else {
+        processMinedKey(key, keys_generated, stats);
+      }
+    }
+
+    return true;
+  }, nullptr, "Miner Thread", m_account, false);
+
+  m_miners.add(miner);
+}
+
+void MinerPool::stop() {
+  for (int i = 0; i < m_miners.size(); ++i) {
+    m_miners[i]->signalThreadShouldExit();
+  }
+
+  for (int i = 0; i < m_miners.size(); ++i) {
+    m_miners[i]->waitForThreadToExit(-1);
+  }
+
+  m_miners.clear();
+
+  // No miner thread references the stats anymore.
+  m_stoppedMinersKeys = getTotalKeysGenerated();
+  for (auto stats : m_threadStats) {
+    m_stoppedMinersProcessTimes.insert(m_stoppedMinersProcessTimes.end(),
+                                       stats->process_times_ns.begin(), stats->process_times_ns.end());
+  }
+  m_threadStats.clear();
+}
+
+int MinerPool::size() const {
+  return m_miners.size();
+}
+
+void MinerPool::processMinedKey(const mined_key& key, int keys_generated, thread_stats* stats) {
+  // Single writer, so a plain load and store is enough and avoids a locked add per batch.
+  stats->keys.store(stats->keys.load(std::memory_order_relaxed) + abs(keys_generated), std::memory_order_relaxed);
+  if (keys_generated <= 0) {
+    return;
+  }
+
+  if (!m_minedKeys.push(key)) {
+    m_droppedKeys.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+bool MinerPool::popMinedKey(mined_key* key) {
+  return m_minedKeys.pop(key);
+}
+
+uint64 MinerPool::getTotalKeysGenerated() const {
+  uint64 total = m_stoppedMinersKeys;
+  for (auto stats : m_threadStats)
+    total += stats->keys.load(std::memory_order_relaxed);
+  return total;
+}
+
+uint64 MinerPool::getDroppedKeys() const {
+  return m_droppedKeys.load(std::memory_order_relaxed);
+}
+
+void MinerPool::setProfilingEnabled(bool enabled) {
+  jassert(m_miners.isEmpty());
+  m_profilingEnabled = enabled;
+}
+
+std::vector<uint32> MinerPool::takeProcessTimes() {
+  jassert(m_miners.isEmpty());
+  std::vector<uint32> times;
+  times.swap(m_stoppedMinersProcessTimes);
+  return times;
+}
@@ -0,0 +1,86 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include <Login/Account.h>
+#include <Utils/AsyncTask.h>
+#include <Utils/MPSCQueue.h>
+#include "JuceHeader.h"
+
+// Miner threads without any UI. Each thread runs a KeyMiner and hands found keys over to a single consumer (the Miner
+// page on the message thread, or the mining benchmark) through a lock-free ring.
+class MinerPool {
+ public:
+  // Key found by a miner thread, waiting to be checked against the slots by the consumer.
+  struct mined_key {
+    unsigned char private_key[32];
+    unsigned char public_key_x[32];
+  };
+
+  // Per miner thread statistics. Only the owning thread writes them, padded so miner threads don't share a cache line.
+  struct thread_stats {
+    std::atomic<uint64> keys {0};
+    // Time spent in processMinedKey, only recorded while profiling is enabled and read after the threads stopped.
+    std::vector<uint32> process_times_ns;
+    char padding[64];
+  };
+
+  explicit MinerPool(Account::Ptr account = nullptr);
+  ~MinerPool();
+
+  // The mask and the difficulty are copied, the thread keeps mining with them until it is stopped.
+  // A non-negative cpu pins the thread to that logical CPU (see MiningScheduler).
+  void addMinerThread(const unsigned char* mask, const unsigned char* difficulty, int cpu = -1);
+  void stop();
+  int size() const;
+
+  // Called from miner threads. Never locks and never blocks.
+  void processMinedKey(const mined_key& key, int keys_generated, thread_stats* stats);
+
+  // Single consumer side.
+  bool popMinedKey(mined_key* key);
+
+  uint64 getTotalKeysGenerated() const;
+  uint64 getDroppedKeys() const;
+
+  // Must be changed while no miner threads are running.
+  void setProfilingEnabled(bool enabled);
+
+  // Returns the recorded processMinedKey times of all threads since the last call and clears them.
+  // Only valid while no miner threads are running.
+  std::vector<uint32> takeProcessTimes();
+
+ private:
+  Account::Ptr m_account;
+  Array<AsyncTask::Ptr> m_miners;
+
+  MPSCQueue<mined_key> m_minedKeys {1024};
+  std::atomic<uint64> m_droppedKeys {0};
+
+  OwnedArray<thread_stats> m_threadStats;
+  uint64 m_stoppedMinersKeys = 0;
+  std::vector<uint32> m_stoppedMinersProcessTimes;
+  bool m_profilingEnabled = false;
+
+  JUCE_DECLARE_NON_COPYABLE(MinerPool)
+};
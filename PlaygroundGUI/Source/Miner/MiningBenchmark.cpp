@@ -0,0 +1,133 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <json.hpp>
+
+#include "MiningBenchmark.h"
+#include "MinerPool.h"
+#include "MiningScheduler.h"
+#include "KeyMiner.h"
+
+#include "automaton/core/io/io.h"
+
+using automaton::core::io::bin2hex;
+using json = nlohmann::json;
+
+const char* const MiningBenchmark::COMMAND_LINE_FLAG = "--mining-benchmark";
+
+bool MiningBenchmark::isRequested(const StringArray& args) {
+  return args.contains(COMMAND_LINE_FLAG);
+}
+
+MiningBenchmark::Options MiningBenchmark::parseCommandLine(const StringArray& args) {
+  Options options;
+  for (int i = 0; i + 1 < args.size(); ++i) {
+    if (args[i] == "--threads") {
+      options.maxThreads = jmax(1, args[i + 1].getIntValue());
+    } else if (args[i] == "--seconds") {
+      options.secondsPerRun = jmax(0.1, args[i + 1].getDoubleValue());
+    } else if (args[i] == "--output") {
+      options.outputFile = File::getCurrentWorkingDirectory().getChildFile(args[i + 1].unquoted());
+    }
+  }
+  return options;
+}
+
+static uint32 percentile(std::vector<uint32>* values, double p) {
+  if (values->empty())
+    return 0;
+
+  const size_t index = static_cast<size_t>(std::ceil(p * values->size())) - 1;
+  std::nth_element(values->begin(), values->begin() + index, values->end());
+  return (*values)[index];
+}
+
+std::string MiningBenchmark::run(const Options& options) {
+  // Fixed parameters, so results are comparable between runs. 12 difficulty bits make about one key in 4096 a
+  // candidate, which exercises the hand over to the consumer every few batches.
+  unsigned char mask[32];
+  unsigned char difficulty[32] = {0};
+  for (int i = 0; i < 32; ++i)
+    mask[i] = static_cast<unsigned char>(0xA5 ^ (i * 0x3D));
+  difficulty[0] = 0xFF;
+  difficulty[1] = 0xF0;
+
+  json report;
+  report["mask"] = bin2hex(std::string(reinterpret_cast<char*>(mask), 32));
+  report["difficulty"] = bin2hex(std::string(reinterpret_cast<char*>(difficulty), 32));
+  report["batch_size"] = KeyMiner::BATCH_SIZE;
+  report["cpus"] = SystemStats::getNumCpus();
+  report["physical_cpus"] = SystemStats::getNumPhysicalCpus();
+  report["seconds_per_run"] = options.secondsPerRun;
+  report["runs"] = json::array();
+
+  // Pin like the miner page does, so the numbers match what mining gets.
+  const auto cpus = MiningScheduler::getPinningOrder();
+
+  double singleThreadKeysPerSecond = 0;
+  for (int threads = 1; threads <= options.maxThreads; ++threads) {
+    MinerPool pool;
+    pool.setProfilingEnabled(true);
+    for (int i = 0; i < threads; ++i)
+      pool.addMinerThread(mask, difficulty, cpus.isEmpty() ? -1 : cpus[i % cpus.size()]);
+
+    // Drain like the Miner page does, just more often so the ring never overflows.
+    MinerPool::mined_key key;
+    auto drainFor = [&](double seconds) {
+      uint64 candidates = 0;
+      const auto end = Time::getMillisecondCounterHiRes() + seconds * 1000.0;
+      while (Time::getMillisecondCounterHiRes() < end) {
+        while (pool.popMinedKey(&key))
+          ++candidates;
+        Thread::sleep(5);
+      }
+      return candidates;
+    };
+
+    drainFor(options.warmupSeconds);
+    const auto startKeys = pool.getTotalKeysGenerated();
+    const auto startTime = Time::getMillisecondCounterHiRes();
+    const auto candidates = drainFor(options.secondsPerRun);
+    const auto keys = pool.getTotalKeysGenerated() - startKeys;
+    const auto elapsed = (Time::getMillisecondCounterHiRes() - startTime) / 1000.0;
+
+    pool.stop();
+    auto processTimes = pool.takeProcessTimes();
+
+    const double keysPerSecond = keys / elapsed;
+    if (threads == 1)
+      singleThreadKeysPerSecond = keysPerSecond;
+
+    json run;
+    run["threads"] = threads;
+    run["keys"] = keys;
+    run["keys_per_second"] = keysPerSecond;
+    run["candidates_per_second"] = candidates / elapsed;
+    run["dropped_keys"] = pool.getDroppedKeys();
+    run["scaling_efficiency"] = singleThreadKeysPerSecond > 0
+        ? keysPerSecond / (threads * singleThreadKeysPerSecond) : 0.0;
+    run["process_mined_key_samples"] = processTimes.size();
+    run["process_mined_key_p99_ns"] = percentile(&processTimes, 0.99);
+    report["runs"].push_back(run);
+  }
+
+  return report.dump(2);
+}
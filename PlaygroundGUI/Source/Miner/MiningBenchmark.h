@@ -0,0 +1,47 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "JuceHeader.h"
+
+// Headless throughput benchmark of the miner threads. Runs the MinerPool used by the Miner page with a fixed mask and
+// difficulty for 1..maxThreads threads and reports keys/s, candidates/s, scaling efficiency and the p99 time spent in
+// MinerPool::processMinedKey as JSON.
+//
+// Started from the command line: Playground --mining-benchmark [--threads N] [--seconds S] [--output file.json]
+class MiningBenchmark {
+ public:
+  static const char* const COMMAND_LINE_FLAG;
+
+  struct Options {
+    int maxThreads = SystemStats::getNumCpus();
+    double secondsPerRun = 5.0;
+    double warmupSeconds = 1.0;
+    File outputFile;
+  };
+
+  static bool isRequested(const StringArray& args);
+  static Options parseCommandLine(const StringArray& args);
+
+  // Blocks until all runs are done and returns the report.
+  static std::string run(const Options& options);
+};
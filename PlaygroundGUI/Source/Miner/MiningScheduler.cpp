@@ -0,0 +1,174 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "MiningScheduler.h"
+#include "Config/Config.h"
+
+static const double CALIBRATION_STEP_SECONDS = 2.0;
+// A thread has to add at least 3% keys/s to be worth keeping.
+static const double CALIBRATION_MIN_GAIN = 1.03;
+static const char* const CALIBRATED_THREADS_FIELD = "mining_threads";
+
+// Groups the logical CPUs by the physical core they belong to, in order of the first logical CPU of each core.
+static std::vector<std::vector<int>> getCores() {
+  const int numCpus = SystemStats::getNumCpus();
+  std::vector<std::vector<int>> cores;
+
+#if JUCE_LINUX
+  std::map<String, size_t> coreIndex;
+  for (int cpu = 0; cpu < numCpus; ++cpu) {
+    const File topology("/sys/devices/system/cpu/cpu" + String(cpu) + "/topology");
+    const auto package = topology.getChildFile("physical_package_id").loadFileAsString().trim();
+    const auto core = topology.getChildFile("core_id").loadFileAsString().trim();
+    if (core.isEmpty()) {
+      cores.clear();
+      break;
+    }
+
+    const auto key = package + ":" + core;
+    auto it = coreIndex.find(key);
+    if (it == coreIndex.end()) {
+      it = coreIndex.emplace(key, cores.size()).first;
+      cores.emplace_back();
+    }
+    cores[it->second].push_back(cpu);
+  }
+#endif
+
+  if (cores.empty()) {
+    // Without topology information assume Windows numbering, where SMT siblings are adjacent.
+    const int physical = jmax(1, SystemStats::getNumPhysicalCpus());
+    const int perCore = numCpus % physical == 0 ? numCpus / physical : 1;
+    for (int cpu = 0; cpu < numCpus; ++cpu) {
+      if (cpu % perCore == 0)
+        cores.emplace_back();
+      cores.back().push_back(cpu);
+    }
+  }
+  return cores;
+}
+
+Array<int> MiningScheduler::getPinningOrder() {
+  const auto cores = getCores();
+  Array<int> order;
+  for (size_t sibling = 0; order.size() < SystemStats::getNumCpus(); ++sibling) {
+    bool added = false;
+    for (const auto& core : cores) {
+      if (sibling < core.size()) {
+        order.add(core[sibling]);
+        added = true;
+      }
+    }
+    if (!added)
+      break;
+  }
+  return order;
+}
+
+MiningScheduler::MiningScheduler(MinerPool* pool)
+    : m_pool(pool)
+    , m_cpus(getPinningOrder()) {
+  memset(m_mask, 0, sizeof(m_mask));
+  memset(m_difficulty, 0, sizeof(m_difficulty));
+}
+
+int MiningScheduler::getCalibratedThreads() const {
+  return static_cast<int>(ConfigFile::getInstance()->get_number(CALIBRATED_THREADS_FIELD, 0));
+}
+
+void MiningScheduler::start(const unsigned char* mask, const unsigned char* difficulty, int numThreads) {
+  stop();
+  memcpy(m_mask, mask, sizeof(m_mask));
+  memcpy(m_difficulty, difficulty, sizeof(m_difficulty));
+
+  if (numThreads <= 0)
+    numThreads = getCalibratedThreads();
+
+  if (numThreads > 0) {
+    for (int i = 0; i < numThreads; ++i)
+      addPinnedThread();
+    return;
+  }
+
+  m_calibrating = true;
+  m_bestKeysPerSecond = 0;
+  m_bestThreads = 0;
+  addPinnedThread();
+  m_stepStartKeys = m_pool->getTotalKeysGenerated();
+  m_stepStartTime = Time::getMillisecondCounterHiRes();
+}
+
+void MiningScheduler::stop() {
+  m_calibrating = false;
+  m_pool->stop();
+}
+
+void MiningScheduler::addThread(const unsigned char* mask, const unsigned char* difficulty) {
+  memcpy(m_mask, mask, sizeof(m_mask));
+  memcpy(m_difficulty, difficulty, sizeof(m_difficulty));
+  addPinnedThread();
+}
+
+void MiningScheduler::addPinnedThread() {
+  const int cpu = m_cpus.isEmpty() ? -1 : m_cpus[m_pool->size() % m_cpus.size()];
+  m_pool->addMinerThread(m_mask, m_difficulty, cpu);
+}
+
+void MiningScheduler::update() {
+  if (!m_calibrating)
+    return;
+
+  const auto now = Time::getMillisecondCounterHiRes();
+  const double elapsed = (now - m_stepStartTime) / 1000.0;
+  if (elapsed < CALIBRATION_STEP_SECONDS)
+    return;
+
+  const auto keys = m_pool->getTotalKeysGenerated();
+  const double keysPerSecond = (keys - m_stepStartKeys) / elapsed;
+  const bool improved = keysPerSecond > m_bestKeysPerSecond * CALIBRATION_MIN_GAIN;
+  if (improved) {
+    m_bestKeysPerSecond = keysPerSecond;
+    m_bestThreads = m_pool->size();
+  }
+
+  if (!improved || m_pool->size() >= SystemStats::getNumCpus()) {
+    finishCalibration();
+    return;
+  }
+
+  addPinnedThread();
+  m_stepStartKeys = m_pool->getTotalKeysGenerated();
+  m_stepStartTime = Time::getMillisecondCounterHiRes();
+}
+
+void MiningScheduler::finishCalibration() {
+  m_calibrating = false;
+  const int bestThreads = jmax(1, m_bestThreads);
+  ConfigFile::getInstance()->set_number(CALIBRATED_THREADS_FIELD, bestThreads);
+
+  if (m_pool->size() != bestThreads) {
+    m_pool->stop();
+    for (int i = 0; i < bestThreads; ++i)
+      addPinnedThread();
+  }
+}
@@ -0,0 +1,66 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "JuceHeader.h"
+#include "MinerPool.h"
+
+// Starts and stops all miner threads of a MinerPool at once, pinning each thread to its own CPU.
+//
+// Physical cores are used before their SMT siblings. When the best thread count for this machine isn't known yet,
+// start() calibrates: it adds one thread per step while the total keys/s keeps growing, then settles on the
+// fastest count and remembers it in the config file.
+class MiningScheduler {
+ public:
+  explicit MiningScheduler(MinerPool* pool);
+
+  // Logical CPUs in pinning order: one per physical core first, then the SMT siblings.
+  static Array<int> getPinningOrder();
+
+  // numThreads <= 0 uses the calibrated count, calibrating first if there is none.
+  void start(const unsigned char* mask, const unsigned char* difficulty, int numThreads = 0);
+  void stop();
+
+  // Adds a single thread on the next CPU of the pinning order.
+  void addThread(const unsigned char* mask, const unsigned char* difficulty);
+
+  bool isCalibrating() const noexcept { return m_calibrating; }
+  int getCalibratedThreads() const;
+
+  // Drives calibration, call periodically from the thread that consumes the pool (e.g. a UI timer).
+  void update();
+
+ private:
+  MinerPool* m_pool;
+  Array<int> m_cpus;
+  unsigned char m_mask[32];
+  unsigned char m_difficulty[32];
+
+  bool m_calibrating = false;
+  uint64 m_stepStartKeys = 0;
+  double m_stepStartTime = 0;
+  double m_bestKeysPerSecond = 0;
+  int m_bestThreads = 0;
+
+  void addPinnedThread();
+  void finishCalibration();
+
+  JUCE_DECLARE_NON_COPYABLE(MiningScheduler)
+};
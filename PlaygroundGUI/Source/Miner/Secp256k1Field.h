@@ -0,0 +1,223 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Arithmetic modulo the secp256k1 field prime p = 2^256 - 2^32 - 977.
+// Values are kept fully reduced in four little-endian 64-bit limbs. This is only meant for the miner hot loop, where
+// the X coordinate of a candidate key is public anyway, so nothing here tries to be constant time.
+struct FieldElement {
+  uint64_t d[4];
+
+  // 2^256 mod p
+  static const uint64_t C = 0x1000003D1ULL;
+
+  static FieldElement zero() {
+    return {{0, 0, 0, 0}};
+  }
+
+  static FieldElement fromBytes(const unsigned char* bytes) {
+    FieldElement r;
+    for (int i = 0; i < 4; ++i) {
+      uint64_t limb = 0;
+      for (int j = 0; j < 8; ++j)
+        limb = (limb << 8) | bytes[(3 - i) * 8 + j];
+      r.d[i] = limb;
+    }
+    r.normalize();
+    return r;
+  }
+
+  void toBytes(unsigned char* bytes) const {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 8; ++j)
+        bytes[(3 - i) * 8 + j] = static_cast<unsigned char>(d[i] >> (56 - 8 * j));
+    }
+  }
+
+  bool isZero() const {
+    return (d[0] | d[1] | d[2] | d[3]) == 0;
+  }
+
+  bool operator==(const FieldElement& other) const {
+    return d[0] == other.d[0] && d[1] == other.d[1] && d[2] == other.d[2] && d[3] == other.d[3];
+  }
+
+  FieldElement operator+(const FieldElement& b) const {
+    FieldElement r;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; ++i)
+      r.d[i] = addCarry(d[i], b.d[i], &carry);
+
+    // a + b < 2p, so after folding 2^256 back in as C the result fits again.
+    if (carry)
+      r.addSmall(C);
+    r.normalize();
+    return r;
+  }
+
+  FieldElement operator-(const FieldElement& b) const {
+    FieldElement r;
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i)
+      r.d[i] = subBorrow(d[i], b.d[i], &borrow);
+
+    // r = a - b + 2^256, adding p is the same as subtracting C and it cannot underflow.
+    if (borrow) {
+      borrow = 0;
+      r.d[0] = subBorrow(r.d[0], C, &borrow);
+      for (int i = 1; i < 4; ++i)
+        r.d[i] = subBorrow(r.d[i], 0, &borrow);
+    }
+    return r;
+  }
+
+  FieldElement operator*(const FieldElement& b) const {
+    uint64_t t[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int i = 0; i < 4; ++i) {
+      uint64_t carry = 0;
+      for (int j = 0; j < 4; ++j)
+        t[i + j] = mulAdd(d[i], b.d[j], t[i + j], carry, &carry);
+      t[i + 4] = carry;
+    }
+    return reduce(t);
+  }
+
+  FieldElement sqr() const {
+    return *this * *this;
+  }
+
+  // a^(p - 2) by square-and-multiply, only used once per mining batch.
+  FieldElement inverse() const {
+    static const uint64_t e[4] = {
+      0xFFFFFFFEFFFFFC2DULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL, 0xFFFFFFFFFFFFFFFFULL
+    };
+
+    FieldElement r = {{1, 0, 0, 0}};
+    for (int i = 3; i >= 0; --i) {
+      for (int bit = 63; bit >= 0; --bit) {
+        r = r.sqr();
+        if ((e[i] >> bit) & 1)
+          r = r * *this;
+      }
+    }
+    return r;
+  }
+
+  // Replaces every element with its inverse using a single field inversion (Montgomery's trick).
+  // None of the elements may be zero; scratch must hold at least n elements.
+  static void batchInverse(FieldElement* elements, FieldElement* scratch, size_t n) {
+    if (n == 0)
+      return;
+
+    scratch[0] = elements[0];
+    for (size_t i = 1; i < n; ++i)
+      scratch[i] = scratch[i - 1] * elements[i];
+
+    FieldElement inv = scratch[n - 1].inverse();
+    for (size_t i = n - 1; i > 0; --i) {
+      const FieldElement elementInverse = inv * scratch[i - 1];
+      inv = inv * elements[i];
+      elements[i] = elementInverse;
+    }
+    elements[0] = inv;
+  }
+
+ private:
+  static uint64_t addCarry(uint64_t a, uint64_t b, uint64_t* carry) {
+    const uint64_t s = a + *carry;
+    const uint64_t c1 = s < a;
+    const uint64_t r = s + b;
+    *carry = c1 | (r < s);
+    return r;
+  }
+
+  static uint64_t subBorrow(uint64_t a, uint64_t b, uint64_t* borrow) {
+    const uint64_t s = a - *borrow;
+    const uint64_t b1 = a < *borrow;
+    const uint64_t r = s - b;
+    *borrow = b1 | (s < b);
+    return r;
+  }
+
+  // Returns the low limb of a * b + c + d and stores the high limb in hi. Cannot overflow 128 bits.
+  static uint64_t mulAdd(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t* hi) {
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 r = static_cast<unsigned __int128>(a) * b + c + d;
+    *hi = static_cast<uint64_t>(r >> 64);
+    return static_cast<uint64_t>(r);
+#else
+    const uint64_t aLo = a & 0xFFFFFFFFULL, aHi = a >> 32;
+    const uint64_t bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+    const uint64_t ll = aLo * bLo;
+    const uint64_t lh = aLo * bHi;
+    const uint64_t hl = aHi * bLo;
+    const uint64_t hh = aHi * bHi;
+    const uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFULL) + (hl & 0xFFFFFFFFULL);
+    uint64_t lo = (ll & 0xFFFFFFFFULL) | (mid << 32);
+    uint64_t high = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    lo += c;
+    high += lo < c;
+    lo += d;
+    high += lo < d;
+    *hi = high;
+    return lo;
+#endif
+  }
+
+  static FieldElement reduce(const uint64_t* t) {
+    // t = lo + hi * 2^256 = lo + hi * C (mod p).
+    FieldElement r;
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; ++i)
+      r.d[i] = mulAdd(t[i + 4], C, t[i], carry, &carry);
+
+    // carry < 2^34, fold it once more.
+    uint64_t hi = 0;
+    r.d[0] = mulAdd(carry, C, r.d[0], 0, &hi);
+    for (int i = 1; i < 4; ++i)
+      r.d[i] = addCarry(r.d[i], 0, &hi);
+
+    if (hi)
+      r.addSmall(C);
+    r.normalize();
+    return r;
+  }
+
+  // Adds a value that is known not to overflow 2^256.
+  void addSmall(uint64_t v) {
+    uint64_t carry = 0;
+    d[0] = addCarry(d[0], v, &carry);
+    for (int i = 1; i < 4; ++i)
+      d[i] = addCarry(d[i], 0, &carry);
+  }
+
+  // Brings a value in [0, 2^256) into [0, p).
+  void normalize() {
+    const bool geP = d[3] == 0xFFFFFFFFFFFFFFFFULL && d[2] == 0xFFFFFFFFFFFFFFFFULL &&
+                     d[1] == 0xFFFFFFFFFFFFFFFFULL && d[0] >= 0xFFFFFFFEFFFFFC2FULL;
+    if (geP) {
+      d[0] -= 0xFFFFFFFEFFFFFC2FULL;
+      d[1] = d[2] = d[3] = 0;
+    }
+  }
+};
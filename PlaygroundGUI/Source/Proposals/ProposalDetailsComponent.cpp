@@ -35,7 +35,7 @@ class VoteSlotsGrid : public SlotsGrid {
     addAndMakeVisible(m_message);
   }
 
-  void setSlots(const Array<uint64>& slots, const std::vector<ValidatorSlot>& validatorSlots) {
+  void setSlots(const Array<uint64>& slots, std::shared_ptr<const ValidatorSlots> validatorSlots) {
     m_slots = slots;
     m_validatorSlots = validatorSlots;
     m_message.setVisible(m_slots.size() == 0);
@@ -68,9 +68,11 @@ class VoteSlotsGrid : public SlotsGrid {
     const auto vote = m_slots[slotIndex];
     String slotInfo;
     slotInfo << "Slot: " << slotIndex << "\n" <<
-                "Vote: " << (vote == 1 ? "YES" : vote == 2 ? "NO" : "Unspecified") << "\n" <<
-                "Owner: " << m_validatorSlots[slotIndex].owner << "\n" <<
-                "Difficulty:" << bin2hex(m_validatorSlots[slotIndex].difficulty) << "\n";
+                "Vote: " << (vote == 1 ? "YES" : vote == 2 ? "NO" : "Unspecified") << "\n";
+    if (m_validatorSlots != nullptr && static_cast<size_t>(slotIndex) < m_validatorSlots->size()) {
+      slotInfo << "Owner: " << m_validatorSlots->getOwnerHex(slotIndex) << "\n" <<
+                  "Difficulty:" << bin2hex(m_validatorSlots->getDifficultyBytes(slotIndex)) << "\n";
+    }
 
     m_popup.m_label.setText(slotInfo, NotificationType::dontSendNotification);
     m_popup.setSize(450, 100);
@@ -85,7 +87,7 @@ class VoteSlotsGrid : public SlotsGrid {
  private:
   Label m_message;
   Array<uint64> m_slots;
-  std::vector<ValidatorSlot> m_validatorSlots;
+  std::shared_ptr<const ValidatorSlots> m_validatorSlots;
 
   class SlotPopup : public Component {
    public:
@@ -24,6 +24,7 @@
 #include "Utils/AsyncTask.h"
 #include "Utils/TasksManager.h"
 #include "Data/AutomatonContractData.h"
+#include "Data/ContractCache.h"
 
 #include "automaton/core/interop/ethereum/eth_contract_curl.h"
 #include "automaton/core/interop/ethereum/eth_transaction.h"
@@ -36,18 +37,23 @@ using automaton::core::io::bin2hex;
 using automaton::core::io::dec2hex;
 using automaton::core::io::hex2dec;
 
-static Proposal::Ptr createOrUpdateProposal(int64 id,
+static bool fetchProposalRecord(int64 id,
+                                AutomatonContractData::Ptr contractData,
+                                CachedProposal* record,
+                                status* resStatus);
+static Proposal::Ptr createOrUpdateProposal(const CachedProposal& record,
                                             Proposal::Ptr proposalToUpdate,
                                             Account::Ptr accountData,
-                                            AutomatonContractData::Ptr contract, status* resStatus);
-static uint64 getNumSlots(AutomatonContractData::Ptr contract, status* resStatus);
-static uint64 getNumSlotsPaid(AutomatonContractData::Ptr contract, uint64 proposalId, status* resStatus);
-static std::vector<std::string> getOwners(AutomatonContractData::Ptr contract, uint64 numOfSlots, status* resStatus);
+                                            AutomatonContractData::Ptr contractData);
+static uint64 parseNumSlotsPaid(const std::string& ballotBox);
 static uint64 getLastProposalId(AutomatonContractData::Ptr contract, status* resStatus);
 static void voteWithSlot(AutomatonContractData::Ptr contract,
                          uint64 id, uint64 slot, uint64 choice,
                          const std::string& privateKey,
                          status* resStatus);
+static status getOwnedSlots(AutomatonContractData::Ptr contract,
+                            const unsigned char* owner,
+                            std::vector<uint64>* ownedSlots);
 
 ProposalsManager::ProposalsManager(Account::Ptr accountData)
   : m_model(std::make_shared<ProposalsModel>())
@@ -59,48 +65,53 @@ ProposalsManager::~ProposalsManager() {
   stopOwnedTasks();
 }
 
-static Proposal::Ptr createOrUpdateProposal(int64 id,
-                                            Proposal::Ptr proposalToUpdate,
-                                            Account::Ptr accountData,
-                                            AutomatonContractData::Ptr contractData, status* resStatus) {
+// Reads the contract calls a proposal is built from, they are cached as they are.
+static bool fetchProposalRecord(int64 id,
+                                AutomatonContractData::Ptr contractData,
+                                CachedProposal* record,
+                                status* resStatus) {
   json jInput;
   jInput.push_back(id);
   std::string params = jInput.dump();
 
-  auto s = contractData->call("getProposalInfo", params);
-  *resStatus = s;
-  if (!s.is_ok())
-    return nullptr;
-
-  const String proposalInfoJson = s.msg;
+  const auto results = contractData->callBatch({
+    {"getProposalInfo", params},
+    {"getProposalData", params},
+    {"calcVoteDifference", params},
+    {"getBallotBox", params}
+  });
+  for (const auto& result : results) {
+    *resStatus = result;
+    if (!result.is_ok())
+      return false;
+  }
 
-  s = contractData->call("getProposalData", params);
-  *resStatus = s;
-  if (!s.is_ok())
-    return nullptr;
+  record->id = static_cast<uint64>(id);
+  record->info = results[0].msg;
+  record->data = results[1].msg;
+  record->voteDifference = results[2].msg;
+  record->ballotBox = results[3].msg;
+  return true;
+}
 
-  const String proposalDataJson = s.msg;
+static Proposal::Ptr createOrUpdateProposal(const CachedProposal& record,
+                                            Proposal::Ptr proposalToUpdate,
+                                            Account::Ptr accountData,
+                                            AutomatonContractData::Ptr contractData) {
+  const String proposalInfoJson = record.info;
+  const String proposalDataJson = record.data;
   auto proposal = proposalToUpdate;
   if (proposal == nullptr) {
-    proposal = std::make_shared<Proposal>(id, proposalInfoJson, proposalDataJson);
+    proposal = std::make_shared<Proposal>(record.id, proposalInfoJson, proposalDataJson);
   } else {
     proposal->setData(proposalInfoJson, proposalDataJson);
   }
 
-  s = contractData->call("calcVoteDifference", params);
-  *resStatus = s;
-  if (!s.is_ok())
-    return nullptr;
-
-  json j_output = json::parse(s.msg);
+  json j_output = json::parse(record.voteDifference);
   const int approvalRating = std::stoi((*j_output.begin()).get<std::string>());
   proposal->setApprovalRating(approvalRating);
 
-  const auto numSlotsPaid = getNumSlotsPaid(contractData, id, &s);
-  *resStatus = s;
-  if (!s.is_ok())
-    return nullptr;
-
+  const auto numSlotsPaid = parseNumSlotsPaid(record.ballotBox);
   proposal->setNumSlotsPaid(numSlotsPaid);
   const bool areAllSlotsPaid = (numSlotsPaid == contractData->getSlotsNumber());
   proposal->setAllSlotsPaid(areAllSlotsPaid);
@@ -118,10 +129,32 @@ static Proposal::Ptr createOrUpdateProposal(int64 id,
 }
 
 bool ProposalsManager::fetchProposals() {
+  // Proposals of the last session are shown until the fetch replaces them.
+  if (m_model->size() == 0) {
+    Array<Proposal::Ptr> proposals;
+    // A record that doesn't parse means a damaged cache file, which counts as no cache.
+    try {
+      for (const auto& record : m_contractData->getCache()->getProposals())
+        proposals.add(createOrUpdateProposal(record, nullptr, m_accountData, m_contractData));
+    } catch (const std::exception& e) {
+      DBG("Ignoring cached proposals: " << e.what());
+      proposals.clear();
+    }
+    m_model->addItems(proposals, NotificationType::sendNotification);
+  }
+
   launchTask([&](AsyncTask* task) {
     auto& s = task->m_status;
 
-    m_model->clear(NotificationType::dontSendNotification);
+    uint64 blockNumber = 0;
+    s = m_contractData->getBlockNumber(&blockNumber);
+    task->logStatus(s, "eth_blockNumber");
+    if (!s.is_ok()) {
+      blockNumber = 0;
+    } else if (blockNumber == m_fetchedBlock) {
+      task->setStatusMessage("No new block since the last fetch");
+      return true;
+    }
 
     const auto lastProposalId = getLastProposalId(m_contractData, &s);
     task->logStatus(s, "getLastProposalId");
@@ -133,17 +166,23 @@ bool ProposalsManager::fetchProposals() {
     // ballotBoxIDs initial value is 99, and the first proposal is at 100
     static const uint32_t PROPOSAL_START_ID = 100;
     Array<Proposal::Ptr> proposals;
+    std::vector<CachedProposal> records;
 
     for (int i = PROPOSAL_START_ID; i <= lastProposalId; ++i) {
-      auto proposal = createOrUpdateProposal(i, nullptr, m_accountData, m_contractData, &s);
+      CachedProposal record;
+      const bool fetched = fetchProposalRecord(i, m_contractData, &record, &s);
       task->logStatus(s, "createOrUpdateProposal");
-      if (proposal == nullptr)
+      if (!fetched)
         return false;
 
-      proposals.add(proposal);
+      proposals.add(createOrUpdateProposal(record, nullptr, m_accountData, m_contractData));
+      records.push_back(std::move(record));
     }
 
+    m_model->clear(NotificationType::dontSendNotification);
     m_model->addItems(proposals, NotificationType::sendNotificationAsync);
+    m_contractData->getCache()->storeProposals(std::move(records));
+    m_fetchedBlock = blockNumber;
     task->setStatusMessage("Fetched " + String(m_model->size()) + " proposals");
 
     return true;
@@ -165,23 +204,35 @@ bool ProposalsManager::fetchProposalVotes(Proposal::Ptr proposal) {
     task->setStatusMessage("Fetching " + String(numOfSlots) + " votes for proposal "
                            + proposal->getTitle() + " (" + String(proposal->getId()) + ")");
 
+    // Votes are read in batches, a batch per slot page keeps the progress moving.
     Array<uint64> slots;
-    for (int i = 0; i < numOfSlots; ++i) {
-      json jInput;
-      jInput.push_back(proposal->getId());
-      jInput.push_back(i);
-      std::string params = jInput.dump();
+    for (int first = 0; first < numOfSlots; first += AutomatonContractData::SLOTS_PAGE_SIZE) {
+      const int last = jmin(first + static_cast<int>(AutomatonContractData::SLOTS_PAGE_SIZE), numOfSlots);
+      std::vector<ContractCall> calls;
+      for (int i = first; i < last; ++i) {
+        json jInput;
+        jInput.push_back(proposal->getId());
+        jInput.push_back(i);
+        calls.push_back({"getVote", jInput.dump()});
+      }
 
-      s = m_contractData->call("getVote", params);
-      task->logStatus(s, String::formatted("getVote id:%llu slot:%d", proposal->getId(), i));
+      const auto results = m_contractData->callBatch(calls);
+      for (int i = first; i < last; ++i) {
+        s = results[i - first];
+        if (!s.is_ok()) {
+          task->logStatus(s, String::formatted("getVote id:%llu slot:%d", proposal->getId(), i));
+          return false;
+        }
 
-      if (!s.is_ok())
-        return false;
+        json j_output = json::parse(s.msg);
+        uint64 slotVote = static_cast<uint64>(String((*j_output.begin()).get<std::string>()).getLargeIntValue());
+        slots.add(slotVote);
+      }
+      task->logStatus(s, String::formatted("getVote id:%llu slots:%d-%d", proposal->getId(), first, last - 1));
+      task->setProgress(last / static_cast<double>(numOfSlots));
 
-      json j_output = json::parse(s.msg);
-      uint64 slotVote = static_cast<uint64>(String((*j_output.begin()).get<std::string>()).getLargeIntValue());
-      slots.add(slotVote);
-      task->setProgress(i / static_cast<double>(numOfSlots));
+      if (task->threadShouldExit())
+        return false;
     }
 
     proposal->setSlots(slots, NotificationType::sendNotification);
@@ -204,7 +255,9 @@ bool ProposalsManager::updateProposal(Proposal::Ptr proposal) {
     auto& s = task->m_status;
     task->setStatusMessage("Updating proposal " + proposal->getTitle() + " (" + String(proposal->getId()) + ")");
 
-    createOrUpdateProposal(proposal->getId(), proposal, m_accountData, m_contractData, &s);
+    CachedProposal record;
+    if (fetchProposalRecord(proposal->getId(), m_contractData, &record, &s))
+      createOrUpdateProposal(record, proposal, m_accountData, m_contractData);
     task->logStatus(s, String::formatted("createOrUpdateProposal id:%llu", proposal->getId()));
 
     task->setStatusMessage("Updated proposal " + proposal->getTitle() + " (" + String(proposal->getId()) + ")");
@@ -313,31 +366,9 @@ static void voteWithSlot(AutomatonContractData::Ptr contract,
   *resStatus = contract->call("castVote",  jInput.dump(), privateKey);
 }
 
-static uint64 getNumSlots(AutomatonContractData::Ptr contract, status* resStatus) {
-  auto s = contract->call("numSlots", "");
-  *resStatus = s;
-  if (!s.is_ok()) {
-    std::cout << "ERROR: " << s.msg << std::endl;
-    return 0;
-  }
-
-  json j_output = json::parse(s.msg);
-  const uint64 slots_number = String((*j_output.begin()).get<std::string>()).getLargeIntValue();
-  return slots_number;
-}
-
-static uint64 getNumSlotsPaid(AutomatonContractData::Ptr contract, uint64 proposalId, status* resStatus) {
-  json j_input;
-  j_input.push_back(proposalId);
-  const std::string params = j_input.dump();
-
-  // Fetch ballot box info for the given proposal
-  const auto s = contract->call("getBallotBox", params);
-  *resStatus = s;
-  if (!s.is_ok())
-    return 0;
-
-  const json ballotBoxJson = json::parse(s.msg);
+// Number of slots paid from the output of getBallotBox.
+static uint64 parseNumSlotsPaid(const std::string& ballotBox) {
+  const json ballotBoxJson = json::parse(ballotBox);
   if (ballotBoxJson.size() != 3) {
     return 0;
   }
@@ -346,26 +377,6 @@ static uint64 getNumSlotsPaid(AutomatonContractData::Ptr contract, uint64 propos
   return numSlotsPaid;
 }
 
-static std::vector<std::string> getOwners(AutomatonContractData::Ptr contract,
-                                          uint64 numOfSlots,
-                                          status* resStatus) {
-  json j_input;
-  j_input.push_back(0);
-  j_input.push_back(numOfSlots);
-  const std::string params = j_input.dump();
-
-  // Fetch owners.
-  const auto s = contract->call("getOwners", params);
-  *resStatus = s;
-  if (!s.is_ok())
-    return std::vector<std::string>();
-
-  // Parse owners.
-  const auto j_output = json::parse(s.msg);
-  std::vector<std::string> owners = (*j_output.begin()).get<std::vector<std::string>>();
-  return owners;
-}
-
 static uint64 getLastProposalId(AutomatonContractData::Ptr contract, status* resStatus) {
   auto s = contract->call("proposalsData", "");
   *resStatus = s;
@@ -381,6 +392,52 @@ static uint64 getLastProposalId(AutomatonContractData::Ptr contract, status* res
   return 0;
 }
 
+// Slots of owner at the chain head. The contract rejects votes of slots that changed owner, so the snapshot is only
+// used if it was read at the head, otherwise the owners are read again.
+static status getOwnedSlots(AutomatonContractData::Ptr contract,
+                            const unsigned char* owner,
+                            std::vector<uint64>* ownedSlots) {
+  const auto snapshot = contract->getSnapshot();
+  const uint32_t numSlots = static_cast<uint32_t>(snapshot->slots.size());
+  uint64 head = 0;
+  auto s = contract->getBlockNumber(&head);
+  if (s.is_ok() && head != 0 && head == snapshot->blockNumber) {
+    for (uint32_t slot = 0; slot < numSlots; ++slot) {
+      if (snapshot->slots.isOwnedBy(slot, owner))
+        ownedSlots->push_back(slot);
+    }
+    return s;
+  }
+
+  std::vector<ContractCall> calls;
+  for (uint32_t start = 0; start < numSlots; start += AutomatonContractData::SLOTS_PAGE_SIZE) {
+    json j_input;
+    j_input.push_back(start);
+    j_input.push_back(jmin(AutomatonContractData::SLOTS_PAGE_SIZE, numSlots - start));
+    calls.push_back({"getOwners", j_input.dump()});
+  }
+
+  const auto results = contract->callBatch(calls);
+  for (size_t i = 0; i < results.size(); ++i) {
+    if (!results[i].is_ok())
+      return results[i];
+
+    const json j_output = json::parse(results[i].msg, nullptr, false);
+    if (!j_output.is_array() || j_output.empty() || !j_output[0].is_array())
+      return status::internal("Invalid getOwners result");
+
+    uint64 slot = i * AutomatonContractData::SLOTS_PAGE_SIZE;
+    unsigned char slotOwner[ValidatorSlots::OWNER_SIZE];
+    for (const auto& address : j_output[0]) {
+      if (address.is_string() && ValidatorSlots::parseOwner(address.get<std::string>(), slotOwner)
+          && memcmp(slotOwner, owner, ValidatorSlots::OWNER_SIZE) == 0)
+        ownedSlots->push_back(slot);
+      ++slot;
+    }
+  }
+  return status::ok();
+}
+
 bool ProposalsManager::castVote(Proposal::Ptr proposal, uint64 choice) {
   if (!proposal)
     return false;
@@ -400,47 +457,40 @@ bool ProposalsManager::castVote(Proposal::Ptr proposal, uint64 choice) {
 
     task->setProgress(0.01);
 
-    const auto numOfSlots = getNumSlots(m_contractData, &s);
-    task->logStatus(s, "getNumSlots");
-
-    if (!s.is_ok())
+    unsigned char callAddress[ValidatorSlots::OWNER_SIZE];
+    if (!ValidatorSlots::parseOwner(m_accountData->getAddress(), callAddress)) {
+      s = status::internal("Invalid account address");
+      task->logStatus(s);
       return false;
+    }
 
-    const auto owners = getOwners(m_contractData, numOfSlots, &s);
+    task->setStatusMessage("Checking slot owners...");
+    std::vector<uint64> ownedSlots;
+    s = getOwnedSlots(m_contractData, callAddress, &ownedSlots);
     task->logStatus(s, "getOwners");
-
-    if (!s.is_ok())
+    if (!s.is_ok() || task->threadShouldExit())
       return false;
 
-    const String callAddress = m_accountData->getAddress().substr(2);
-
-    uint64 numOwnedSlots = 0;
-    bool isOwnerForAnySlot = false;
-    for (uint64 slot = 0; slot < owners.size(); ++slot) {
-      String owner = owners[slot];
-      if (owner.equalsIgnoreCase(callAddress)) {
-        isOwnerForAnySlot = true;
-        ++numOwnedSlots;
-
-        task->setStatusMessage("Voting for slot " + String(slot) + "...");
-        voteWithSlot(m_contractData, proposal->getId(), slot,
-            choice, m_accountData->getPrivateKey(), &s);
-        task->logStatus(s,
-            String::formatted("voteWithSlot proposalId:%llu slot:%lu vote:%s", proposal->getId(), slot, choiceName));
-
-        if (!s.is_ok() || task->threadShouldExit())
-          return false;
-      }
-
-      task->setProgress(slot / static_cast<double>(numOfSlots));
-    }
-
-    if (!isOwnerForAnySlot) {
+    if (ownedSlots.empty()) {
       s = status::internal("You own no single slot. Voting is impossible");
       task->logStatus(s);
       return false;
     }
-    task->setStatusMessage("Successfully voted for " + String(numOwnedSlots) + " slots!");
+
+    for (size_t i = 0; i < ownedSlots.size(); ++i) {
+      const uint64 slot = ownedSlots[i];
+      task->setStatusMessage("Voting for slot " + String(slot) + "...");
+      voteWithSlot(m_contractData, proposal->getId(), slot,
+          choice, m_accountData->getPrivateKey(), &s);
+      task->logStatus(s,
+          String::formatted("voteWithSlot proposalId:%llu slot:%lu vote:%s", proposal->getId(), slot, choiceName));
+
+      if (!s.is_ok() || task->threadShouldExit())
+        return false;
+
+      task->setProgress((i + 1) / static_cast<double>(ownedSlots.size()));
+    }
+    task->setStatusMessage("Successfully voted for " + String(ownedSlots.size()) + " slots!");
 
     return true;
   }, [=](AsyncTask* task) {
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <Utils/TasksOwner.h>
 #include "../Login/Account.h"
 #include "ProposalsModel.h"
@@ -46,6 +48,8 @@ class ProposalsManager : public TasksOwner {
 
   Account::Ptr m_accountData;
   std::shared_ptr<AutomatonContractData> m_contractData;
+  // Chain head of the last successful fetchProposals(), which is skipped until the head moves.
+  std::atomic<uint64> m_fetchedBlock {0};
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProposalsManager)
 };
@@ -0,0 +1,171 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__AVX2__) || defined(__LZCNT__)
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Kernels for 256-bit big-endian values such as slot difficulties, masks and public key X coordinates.
+// They run per candidate key in the miner and per slot when grids are repainted, so they don't allocate and use
+// AVX2 / LZCNT when the compiler targets them, with a scalar fallback otherwise.
+namespace Bits256 {
+
+static const size_t SIZE = 32;
+
+// Word level helpers, usable in constant expressions. Words are ordered most significant first.
+constexpr unsigned countLeadingZerosScalar(uint64_t x) {
+  unsigned n = 0;
+  for (uint64_t bit = 1ULL << 63; bit != 0 && (x & bit) == 0; bit >>= 1)
+    ++n;
+  return n;
+}
+
+constexpr int compareWords(const uint64_t* a, const uint64_t* b) {
+  for (int i = 0; i < 4; ++i) {
+    if (a[i] != b[i])
+      return a[i] < b[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+constexpr uint64_t loadWord(const unsigned char* bytes) {
+  uint64_t word = 0;
+  for (int i = 0; i < 8; ++i)
+    word = (word << 8) | bytes[i];
+  return word;
+}
+
+inline unsigned countLeadingZeros(uint64_t x) {
+#if defined(__LZCNT__)
+  return static_cast<unsigned>(_lzcnt_u64(x));
+#elif defined(__GNUC__)
+  return x ? static_cast<unsigned>(__builtin_clzll(x)) : 64;
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;  // NOLINT(runtime/int)
+  return _BitScanReverse64(&index, x) ? 63 - static_cast<unsigned>(index) : 64;
+#else
+  return countLeadingZerosScalar(x);
+#endif
+}
+
+inline unsigned countTrailingZeros32(uint32_t x) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_ctz(x));
+#elif defined(_MSC_VER)
+  unsigned long index;  // NOLINT(runtime/int)
+  _BitScanForward(&index, x);
+  return static_cast<unsigned>(index);
+#else
+  unsigned n = 0;
+  while ((x & 1) == 0) {
+    x >>= 1;
+    ++n;
+  }
+  return n;
+#endif
+}
+
+// Number of leading one bits, the "difficulty bits" shown for slots. Works on any length.
+inline unsigned countLeadingOnes(const unsigned char* bytes, size_t size) {
+  unsigned result = 0;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    const uint64_t inverted = ~loadWord(bytes + i);
+    if (inverted)
+      return result + countLeadingZeros(inverted);
+    result += 64;
+  }
+  for (; i < size; ++i) {
+    const uint64_t inverted = static_cast<uint8_t>(~bytes[i]);
+    if (inverted)
+      return result + countLeadingZeros(inverted) - 56;
+    result += 8;
+  }
+  return result;
+}
+
+inline unsigned countLeadingOnes(const std::string& s) {
+  return countLeadingOnes(reinterpret_cast<const unsigned char*>(s.data()), s.size());
+}
+
+// Returns a negative value, zero or a positive value if a is less than, equal to or greater than b.
+inline int compare(const unsigned char* a, const unsigned char* b) {
+#if defined(__AVX2__)
+  const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+  const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+  const uint32_t differ = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+  if (differ == 0)
+    return 0;
+  const unsigned i = countTrailingZeros32(differ);
+  return static_cast<int>(a[i]) - static_cast<int>(b[i]);
+#else
+  for (size_t i = 0; i < SIZE; i += 8) {
+    const uint64_t wa = loadWord(a + i);
+    const uint64_t wb = loadWord(b + i);
+    if (wa != wb)
+      return wa < wb ? -1 : 1;
+  }
+  return 0;
+#endif
+}
+
+inline bool isGreater(const unsigned char* a, const unsigned char* b) {
+  return compare(a, b) > 0;
+}
+
+// Strings that are not 32 bytes long (e.g. a slot which was not read yet) count as zero.
+inline bool isGreater(const std::string& a, const std::string& b) {
+  static const unsigned char zero[SIZE] = {0};
+  const auto pa = a.size() == SIZE ? reinterpret_cast<const unsigned char*>(a.data()) : zero;
+  const auto pb = b.size() == SIZE ? reinterpret_cast<const unsigned char*>(b.data()) : zero;
+  return compare(pa, pb) > 0;
+}
+
+// out = value ^ mask, out may alias value.
+inline void maskXor(const unsigned char* value, const unsigned char* mask, unsigned char* out) {
+#if defined(__AVX2__)
+  const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(value));
+  const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_xor_si256(v, m));
+#else
+  for (size_t i = 0; i < SIZE; ++i)
+    out[i] = value[i] ^ mask[i];
+#endif
+}
+
+// out = a - b modulo 2^256, out may alias a or b.
+inline void subtract(const unsigned char* a, const unsigned char* b, unsigned char* out) {
+  unsigned borrow = 0;
+  for (int i = static_cast<int>(SIZE) - 1; i >= 0; --i) {
+    const unsigned d = static_cast<unsigned>(a[i]) - b[i] - borrow;
+    borrow = (d >> 8) & 1;
+    out[i] = static_cast<unsigned char>(d);
+  }
+}
+
+}  // namespace Bits256
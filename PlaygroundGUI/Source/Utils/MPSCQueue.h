@@ -0,0 +1,91 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "JuceHeader.h"
+
+// Bounded lock-free multi-producer single-consumer ring (Vyukov's bounded queue).
+// push() may be called from any thread and fails instead of blocking when the ring is full.
+// pop() must only ever be called from one thread at a time.
+template <typename T>
+class MPSCQueue {
+ public:
+  explicit MPSCQueue(size_t capacity)
+      : m_mask(capacity - 1)
+      , m_cells(new Cell[capacity]) {
+    jassert(capacity >= 2 && (capacity & (capacity - 1)) == 0);  // Capacity must be a power of two
+    for (size_t i = 0; i < capacity; ++i)
+      m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  bool push(const T& item) {
+    Cell* cell;
+    size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      cell = &m_cells[pos & m_mask];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = item;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T* item) {
+    Cell& cell = m_cells[m_dequeuePos & m_mask];
+    const size_t seq = cell.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(m_dequeuePos + 1) < 0)
+      return false;
+
+    *item = cell.data;
+    cell.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+    ++m_dequeuePos;
+    return true;
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  const size_t m_mask;
+  std::unique_ptr<Cell[]> m_cells;
+
+  // Keep the producers' cursor away from the consumer's one.
+  char m_padding0[64];
+  std::atomic<size_t> m_enqueuePos {0};
+  char m_padding1[64];
+  size_t m_dequeuePos = 0;
+
+  JUCE_DECLARE_NON_COPYABLE(MPSCQueue)
+};
@@ -0,0 +1,391 @@
+/*
+ * Automaton Playground
+ * Copyright (c) 2020 The Automaton Authors.
+ * Copyright (c) 2020 The automaton.network Authors.
+ *
+ * Automaton Playground is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * any later version.
+ *
+ * Automaton Playground is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with Automaton Playground.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "Bits256.h"
+
+// Fixed width unsigned 256-bit integer. Never allocates, meant for values that are computed per mined key or per slot.
+// Also used for wei amounts and for the decimal numbers the contract returns, so it parses and formats decimal and
+// hex text and divides by powers of ten without going through a big integer library.
+class Uint256 {
+ public:
+  // 2^256 - 1 has 78 decimal digits.
+  static const size_t MAX_DECIMAL_DIGITS = 78;
+  static const size_t HEX_DIGITS = 64;
+
+  constexpr Uint256() : m_words{0, 0, 0, 0} {
+  }
+
+  constexpr explicit Uint256(uint64_t value) : m_words{value, 0, 0, 0} {
+  }
+
+  // 32 big-endian bytes, the format of keys and difficulties.
+  static Uint256 fromBigEndian(const unsigned char* bytes) {
+    Uint256 r;
+    for (int i = 0; i < 4; ++i) {
+      uint64_t word = 0;
+      for (int j = 0; j < 8; ++j)
+        word = (word << 8) | bytes[(3 - i) * 8 + j];
+      r.m_words[i] = word;
+    }
+    return r;
+  }
+
+  // Shorter strings are treated as having leading zero bytes, longer ones are truncated to the last 32 bytes.
+  static Uint256 fromBigEndian(const std::string& bytes) {
+    unsigned char padded[32] = {0};
+    const size_t size = bytes.size() < 32 ? bytes.size() : 32;
+    for (size_t i = 0; i < size; ++i)
+      padded[32 - size + i] = static_cast<unsigned char>(bytes[bytes.size() - size + i]);
+    return fromBigEndian(padded);
+  }
+
+  void toBigEndian(unsigned char* bytes) const {
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 8; ++j)
+        bytes[(3 - i) * 8 + j] = static_cast<unsigned char>(m_words[i] >> (56 - 8 * j));
+    }
+  }
+
+  std::string toBigEndian() const {
+    unsigned char bytes[32];
+    toBigEndian(bytes);
+    return std::string(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+  }
+
+  // Plain decimal digits. Returns false and leaves value unchanged on any other character or when the number doesn't
+  // fit in 256 bits. An empty string is zero. Nine digits are added at a time, so it is a single pass over the text.
+  static bool fromDecimal(const char* digits, size_t size, Uint256* value) {
+    Uint256 r;
+    size_t i = 0;
+    while (i < size) {
+      const size_t chunkEnd = i + 9 < size ? i + 9 : size;
+      uint32_t chunk = 0;
+      uint32_t factor = 1;
+      for (; i < chunkEnd; ++i) {
+        if (digits[i] < '0' || digits[i] > '9')
+          return false;
+        chunk = chunk * 10 + static_cast<uint32_t>(digits[i] - '0');
+        factor *= 10;
+      }
+      if (r.multiplyAdd(factor, chunk) != 0)
+        return false;
+    }
+    *value = r;
+    return true;
+  }
+
+  static bool fromDecimal(const std::string& digits, Uint256* value) {
+    return fromDecimal(digits.data(), digits.size(), value);
+  }
+
+  // Hex digits in either case, with or without 0x. Up to 64 digits, shorter strings have implied leading zeros.
+  static bool fromHex(const char* digits, size_t size, Uint256* value) {
+    if (size >= 2 && digits[0] == '0' && (digits[1] == 'x' || digits[1] == 'X')) {
+      digits += 2;
+      size -= 2;
+    }
+    if (size > HEX_DIGITS)
+      return false;
+
+    Uint256 r;
+    for (size_t i = 0; i < size; ++i) {
+      const int digit = hexDigitValue(digits[i]);
+      if (digit < 0)
+        return false;
+      const size_t bit = 4 * (size - 1 - i);
+      r.m_words[bit / 64] |= static_cast<uint64_t>(digit) << (bit % 64);
+    }
+    *value = r;
+    return true;
+  }
+
+  static bool fromHex(const std::string& digits, Uint256* value) {
+    return fromHex(digits.data(), digits.size(), value);
+  }
+
+  // Writes the decimal digits without leading zeros or a terminator into a buffer of at least MAX_DECIMAL_DIGITS
+  // characters and returns their number. Digits are produced nine at a time.
+  size_t toDecimal(char* buffer) const {
+    char reversed[MAX_DECIMAL_DIGITS];
+    size_t size = 0;
+    Uint256 rest = *this;
+    do {
+      uint32_t chunk = rest.divide(1000000000);
+      const bool last = rest.isZero();
+      for (int i = 0; i < 9 && (!last || chunk != 0 || size == 0); ++i) {
+        reversed[size++] = static_cast<char>('0' + chunk % 10);
+        chunk /= 10;
+      }
+    } while (!rest.isZero());
+
+    for (size_t i = 0; i < size; ++i)
+      buffer[i] = reversed[size - 1 - i];
+    return size;
+  }
+
+  std::string toDecimal() const {
+    char buffer[MAX_DECIMAL_DIGITS];
+    return std::string(buffer, toDecimal(buffer));
+  }
+
+  // Writes exactly HEX_DIGITS lower case digits without 0x, the format of masks and difficulties in the config.
+  void toHex(char* buffer) const {
+    static const char* const DIGITS = "0123456789abcdef";
+    for (size_t i = 0; i < HEX_DIGITS; ++i) {
+      const size_t bit = 4 * (HEX_DIGITS - 1 - i);
+      buffer[i] = DIGITS[(m_words[bit / 64] >> (bit % 64)) & 0xF];
+    }
+  }
+
+  std::string toHex() const {
+    char buffer[HEX_DIGITS];
+    toHex(buffer);
+    return std::string(buffer, sizeof(buffer));
+  }
+
+  // Least significant word first.
+  constexpr uint64_t getWord(int index) const {
+    return m_words[index];
+  }
+
+  constexpr bool isZero() const {
+    return (m_words[0] | m_words[1] | m_words[2] | m_words[3]) == 0;
+  }
+
+  // Remainder of the division by a non-zero 32-bit divisor, e.g. the slot of a key. Powers of two only mask the low
+  // word, everything else is long division by 32-bit digits, which never overflows 64-bit arithmetic.
+  uint32_t mod(uint32_t divisor) const {
+    if ((divisor & (divisor - 1)) == 0)
+      return static_cast<uint32_t>(m_words[0] & (divisor - 1));
+
+    uint64_t remainder = 0;
+    for (int i = 3; i >= 0; --i) {
+      remainder = ((remainder << 32) | (m_words[i] >> 32)) % divisor;
+      remainder = ((remainder << 32) | (m_words[i] & 0xFFFFFFFFULL)) % divisor;
+    }
+    return static_cast<uint32_t>(remainder);
+  }
+
+  // Divides in place by a non-zero 32-bit divisor and returns the remainder.
+  uint32_t divide(uint32_t divisor) {
+    uint64_t remainder = 0;
+    for (int i = 3; i >= 0; --i) {
+      const uint64_t high = (remainder << 32) | (m_words[i] >> 32);
+      remainder = high % divisor;
+      const uint64_t low = (remainder << 32) | (m_words[i] & 0xFFFFFFFFULL);
+      remainder = low % divisor;
+      m_words[i] = ((high / divisor) << 32) | (low / divisor);
+    }
+    return static_cast<uint32_t>(remainder);
+  }
+
+  // Divides in place by 10^exponent, e.g. wei to ether. The remainder, if requested, has fewer than exponent digits.
+  void divideByPowerOfTen(int exponent, Uint256* remainder = nullptr) {
+    Uint256 r;
+    Uint256 scale(1);  // Product of the divisors of the previous steps
+    for (; exponent > 0; exponent -= 9) {
+      const uint32_t divisor = getPowerOfTen(exponent < 9 ? exponent : 9);
+      Uint256 part(divide(divisor));
+      part.multiply(scale);
+      r.add(part);
+      scale.multiplyAdd(divisor, 0);
+    }
+    if (remainder != nullptr)
+      *remainder = r;
+  }
+
+  // Multiplies in place by 10^exponent, e.g. ether to wei. Returns false on overflow.
+  bool multiplyByPowerOfTen(int exponent) {
+    for (; exponent > 0; exponent -= 9) {
+      if (multiplyAdd(getPowerOfTen(exponent < 9 ? exponent : 9), 0) != 0)
+        return false;
+    }
+    return true;
+  }
+
+  // Long division by any non-zero divisor. Returns false if divisor is zero. 32-bit divisors take the fast path,
+  // others shift and subtract from the highest set bit of the dividend.
+  static bool divide(const Uint256& dividend, const Uint256& divisor, Uint256* quotient, Uint256* remainder) {
+    if (divisor.isZero())
+      return false;
+
+    if ((divisor.m_words[0] >> 32) == 0 && (divisor.m_words[1] | divisor.m_words[2] | divisor.m_words[3]) == 0) {
+      Uint256 q = dividend;
+      const uint32_t r = q.divide(static_cast<uint32_t>(divisor.m_words[0]));
+      *quotient = q;
+      *remainder = Uint256(r);
+      return true;
+    }
+
+    Uint256 q;
+    Uint256 r;
+    for (int bit = dividend.getBitLength() - 1; bit >= 0; --bit) {
+      const bool carry = (r.m_words[3] >> 63) != 0;
+      r.shiftLeft1();
+      r.m_words[0] |= (dividend.m_words[bit / 64] >> (bit % 64)) & 1;
+      // With the carry the shifted remainder is above 2^256 and therefore above the divisor, the wrapping subtraction
+      // still yields the right value.
+      if (carry || r >= divisor) {
+        r.subtract(divisor);
+        q.m_words[bit / 64] |= 1ULL << (bit % 64);
+      }
+    }
+    *quotient = q;
+    *remainder = r;
+    return true;
+  }
+
+  // Returns false on overflow, leaving the wrapped sum.
+  bool add(const Uint256& other) {
+    uint64_t carry = 0;
+    for (int i = 0; i < 4; ++i) {
+      const uint64_t sum = m_words[i] + other.m_words[i];
+      const uint64_t total = sum + carry;
+      carry = (sum < m_words[i] || total < sum) ? 1 : 0;
+      m_words[i] = total;
+    }
+    return carry == 0;
+  }
+
+  // Returns false when other is larger, leaving the wrapped difference.
+  bool subtract(const Uint256& other) {
+    uint64_t borrow = 0;
+    for (int i = 0; i < 4; ++i) {
+      const uint64_t difference = m_words[i] - other.m_words[i];
+      const uint64_t next = (m_words[i] < other.m_words[i] || difference < borrow) ? 1 : 0;
+      m_words[i] = difference - borrow;
+      borrow = next;
+    }
+    return borrow == 0;
+  }
+
+  // Returns false on overflow, leaving the wrapped product.
+  bool multiply(const Uint256& other) {
+    Uint256 product;
+    bool overflow = false;
+    for (int i = 0; i < 8; ++i) {
+      const uint32_t digit = other.getHalfWord(i);
+      if (digit == 0)
+        continue;
+      Uint256 partial = *this;
+      overflow |= partial.multiplyAdd(digit, 0) != 0;
+      for (int shift = 0; shift < i; ++shift)
+        overflow |= partial.shiftLeft32();
+      overflow |= !product.add(partial);
+    }
+    *this = product;
+    return !overflow;
+  }
+
+  // Number of significant bits, 0 for zero.
+  int getBitLength() const {
+    for (int i = 3; i >= 0; --i) {
+      if (m_words[i] != 0)
+        return i * 64 + 64 - static_cast<int>(Bits256::countLeadingZeros(m_words[i]));
+    }
+    return 0;
+  }
+
+  bool operator<(const Uint256& other) const {
+    for (int i = 3; i >= 0; --i) {
+      if (m_words[i] != other.m_words[i])
+        return m_words[i] < other.m_words[i];
+    }
+    return false;
+  }
+
+  bool operator>(const Uint256& other) const {
+    return other < *this;
+  }
+
+  bool operator<=(const Uint256& other) const {
+    return !(other < *this);
+  }
+
+  bool operator>=(const Uint256& other) const {
+    return !(*this < other);
+  }
+
+  bool operator==(const Uint256& other) const {
+    return m_words[0] == other.m_words[0] && m_words[1] == other.m_words[1] &&
+           m_words[2] == other.m_words[2] && m_words[3] == other.m_words[3];
+  }
+
+  bool operator!=(const Uint256& other) const {
+    return !(*this == other);
+  }
+
+ private:
+  uint64_t m_words[4];  // Least significant first
+
+  // 10^digits for digits up to 9, the largest power of ten below 2^32.
+  static uint32_t getPowerOfTen(int digits) {
+    static const uint32_t POWERS_OF_TEN[10] = {
+        1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+    return POWERS_OF_TEN[digits];
+  }
+
+  static int hexDigitValue(char c) {
+    if (c >= '0' && c <= '9')
+      return c - '0';
+    if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+    return -1;
+  }
+
+  uint32_t getHalfWord(int index) const {
+    return static_cast<uint32_t>(m_words[index / 2] >> (32 * (index % 2)));
+  }
+
+  // this = this * factor + addend, 32 bits at a time so it never overflows 64-bit arithmetic. Returns the carry out
+  // of the top word, non-zero on overflow.
+  uint32_t multiplyAdd(uint32_t factor, uint32_t addend) {
+    uint64_t carry = addend;
+    for (int i = 0; i < 4; ++i) {
+      const uint64_t low = (m_words[i] & 0xFFFFFFFFULL) * factor + carry;
+      const uint64_t high = (m_words[i] >> 32) * factor + (low >> 32);
+      m_words[i] = (high << 32) | (low & 0xFFFFFFFFULL);
+      carry = high >> 32;
+    }
+    return static_cast<uint32_t>(carry);
+  }
+
+  void shiftLeft1() {
+    for (int i = 3; i > 0; --i)
+      m_words[i] = (m_words[i] << 1) | (m_words[i - 1] >> 63);
+    m_words[0] <<= 1;
+  }
+
+  // Returns true if non-zero bits were shifted out.
+  bool shiftLeft32() {
+    const bool overflow = (m_words[3] >> 32) != 0;
+    for (int i = 3; i > 0; --i)
+      m_words[i] = (m_words[i] << 32) | (m_words[i - 1] >> 32);
+    m_words[0] <<= 32;
+    return overflow;
+  }
+};
@@ -19,6 +19,7 @@
 
 #include "Utils.h"
 
+#include <cstring>
 #include <secp256k1_recovery.h>
 #include <secp256k1.h>
 #include "automaton/core/io/io.h"
@@ -67,25 +68,40 @@ std::unique_ptr<Drawable> Utils::loadSVG(const String& xmlData) {
   return std::unique_ptr<Drawable>(Drawable::createFromSVG(*svg));
 }
 
-static std::map<CoinUnit, String> coinUnitsFactor{
-    {CoinUnit::Gwei,  "1000000000"},
-    {CoinUnit::ether, "1000000000000000000"},
-    {CoinUnit::AUTO, "1000000000000000000"}
-};
+static bool parseDecimal(const String& text, Uint256* value) {
+  const auto utf8 = text.toRawUTF8();
+  return Uint256::fromDecimal(utf8, strlen(utf8), value);
+}
 
 String Utils::fromWei(CoinUnit unitTo, const String& value) {
-  BigInteger whole;
-  whole.parseString(value, 10);
-  BigInteger factor;
-  factor.parseString(coinUnitsFactor[unitTo], 10);
-  BigInteger remainder;
-  whole.divideBy(factor, remainder);
-
-  auto decimals = remainder.toString(10).paddedLeft('0', static_cast<int>(unitTo)).trimCharactersAtEnd("0");
-  if (decimals.isEmpty())
-    return whole.toString(10);
-
-  return whole.toString(10) + "." + decimals;
+  Uint256 wei;
+  if (!parseDecimal(value, &wei))
+    return String();
+  return fromWei(unitTo, wei);
+}
+
+String Utils::fromWei(CoinUnit unitTo, const Uint256& value) {
+  // The unit is the number of decimals.
+  const int unitDecimals = static_cast<int>(unitTo);
+  Uint256 whole = value;
+  Uint256 remainder;
+  whole.divideByPowerOfTen(unitDecimals, &remainder);
+
+  char text[Uint256::MAX_DECIMAL_DIGITS + 1 + Uint256::MAX_DECIMAL_DIGITS];
+  size_t size = whole.toDecimal(text);
+  if (!remainder.isZero()) {
+    char digits[Uint256::MAX_DECIMAL_DIGITS];
+    const size_t numDigits = remainder.toDecimal(digits);
+    text[size++] = '.';
+    for (size_t i = numDigits; i < static_cast<size_t>(unitDecimals); ++i)
+      text[size++] = '0';
+    size_t significant = numDigits;
+    while (digits[significant - 1] == '0')
+      --significant;
+    memcpy(text + size, digits, significant);
+    size += significant;
+  }
+  return String(text, size);
 }
 
 String Utils::toWei(CoinUnit unitTo, const String& value) {
@@ -101,44 +117,45 @@ String Utils::toWei(CoinUnit unitTo, const String& value) {
     decimals = tokens[1];
   }
 
-  BigInteger factor;
-  auto unitFactor = coinUnitsFactor[unitTo].dropLastCharacters(decimals.length());
-  if (unitFactor.isEmpty())
+  const int unitDecimals = static_cast<int>(unitTo);
+  if (decimals.length() > unitDecimals)
     return "";  // Exceeds max precision
 
-  factor.parseString(unitFactor, 10);
-
-  BigInteger result;
-  result.parseString(whole + decimals, 10);
+  Uint256 result;
+  if (!parseDecimal(whole + decimals, &result) || !result.multiplyByPowerOfTen(unitDecimals - decimals.length()))
+    return "";
 
-  return (result * factor).toString(10);
+  return result.toDecimal();
 }
 
 String Utils::divideBigInt(const String& dividend, const String& divisor, uint64 precision) {
-  BigInteger a;
-  a.parseString(dividend, 10);
-  BigInteger b;
-  b.parseString(divisor, 10);
+  Uint256 a;
+  Uint256 b;
+  if (!parseDecimal(dividend, &a) || !parseDecimal(divisor, &b))
+    return String();
+  return divideBigInt(a, b, precision);
+}
 
-  BigInteger reminder;
-  a.divideBy(b, reminder);
+String Utils::divideBigInt(const Uint256& dividend, const Uint256& divisor, uint64 precision) {
+  Uint256 quotient;
+  Uint256 reminder;
+  if (!Uint256::divide(dividend, divisor, &quotient, &reminder))
+    return String();
 
-  String decimals;
-  for (int i = 0; i < precision; ++i) {
-    reminder *= 10;
-    BigInteger reminder2;
-    reminder.divideBy(b, reminder2);
-    decimals += reminder.toString(10);
-    reminder = reminder2;
-
-    if (reminder2.isZero())
+  String result = quotient.toDecimal();
+  if (reminder.isZero() || precision == 0)
+    return result;
+
+  result << ".";
+  for (uint64 i = 0; i < precision && !reminder.isZero(); ++i) {
+    // The reminder is below the divisor, so this only overflows for divisors close to 2^256.
+    if (!reminder.multiplyByPowerOfTen(1))
       break;
+    Uint256 digit;
+    Uint256::divide(reminder, divisor, &digit, &reminder);
+    result << static_cast<char>('0' + digit.getWord(0));
   }
-
-  if (decimals.isEmpty())
-    return a.toString(10);
-
-  return a.toString(10) + "." + decimals;
+  return result;
 }
 
 bool Utils::isZeroTime(const Time& time) {
@@ -177,6 +194,30 @@ class UtilsTest : public UnitTest {
     expect(Utils::divideBigInt("1000", "6", 10) == "166.6666666666");
     expect(Utils::divideBigInt("123456789", "12345678900008", 10) == "0.0000099999");
     expect(Utils::divideBigInt("12345678900008", "123456789", 10) == "100000.0000000648");
+    expect(Utils::divideBigInt("10", "0", 10).isEmpty());
+
+    beginTest("Uint256 decimal and hex");
+    const std::string max = "115792089237316195423570985008687907853269984665640564039457584007913129639935";
+    Uint256 value;
+    expect(Uint256::fromDecimal(max, &value));
+    expect(value.toDecimal() == max);
+    expect(value.toHex() == std::string(64, 'f'));
+    expect(!Uint256::fromDecimal(max + "0", &value));
+    expect(!Uint256::fromDecimal("12a", &value));
+    expect(Uint256::fromHex("0x1000000000", &value));
+    expect(value.toDecimal() == "68719476736");
+    expect(!Uint256::fromHex(std::string(65, '1'), &value));
+    expect(Uint256().toDecimal() == "0");
+
+    beginTest("Uint256 division");
+    expect(Uint256::fromDecimal("1000000000000000000000000123", &value));
+    Uint256 remainder;
+    value.divideByPowerOfTen(18, &remainder);
+    expect(value.toDecimal() == "1000000000" && remainder.toDecimal() == "123");
+    Uint256 quotient;
+    expect(Uint256::divide(Uint256(1000), Uint256(7), &quotient, &remainder));
+    expect(quotient == Uint256(142) && remainder == Uint256(6));
+    expect(Uint256(3) < Uint256(4) && Uint256(4) >= Uint256(4));
   }
 };
 
@@ -20,6 +20,7 @@
 #pragma once
 
 #include "JuceHeader.h"
+#include "Uint256.h"
 
 enum class CoinUnit {Gwei = 9, ether = 18, AUTO = 18};
 
@@ -27,9 +28,12 @@ class Utils {
  public:
   static std::string gen_ethereum_address(const std::string& privkey_hex);
   static std::unique_ptr<Drawable> loadSVG(const String& xmlData);
+  // Decimal amounts. Text that isn't a number or doesn't fit in 256 bits yields an empty string.
   static String fromWei(CoinUnit unitTo, const String& value);
+  static String fromWei(CoinUnit unitTo, const Uint256& value);
   static String toWei(CoinUnit unitTo, const String& value);
   static String divideBigInt(const String& dividend, const String& divisor, uint64 precision);
+  static String divideBigInt(const Uint256& dividend, const Uint256& divisor, uint64 precision);
 
   static bool isZeroTime(const Time& time);
   // Return an address without "0x"